@@ -0,0 +1,155 @@
+#pragma once
+
+#include "kafka/Project.h"
+
+#include "kafka/Types.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace KAFKA_API {
+
+/**
+ * Decides the maximum number of records for each poll, with the observed processing time per record, the target poll interval, and the current lag.
+ *  - While lagging behind, the batch grows (up to `maxRecords`), as long as a batch could be processed within the target interval, -- for higher throughput.
+ *  - While caught up, the batch shrinks towards the lag (down to `minRecords`), thus a poll would not wait for a batch which would never be filled, -- for lower latency.
+ * Note: With `minRecords` equal to `maxRecords`, the controller is disabled (i.e, always `maxRecords`).
+ */
+class AdaptivePollController
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * The decisions made by the controller, and the observations they're based on.
+     */
+    struct Metrics
+    {
+        /**
+         * The maximum number of records for the latest poll.
+         */
+        std::size_t   maxPollRecords            = 0;
+
+        /**
+         * Average processing time (in microseconds) per record (i.e, the time between polls, divided by the number of records returned).
+         */
+        double        recordProcessingTimeUs    = 0;
+
+        /**
+         * The latest lag observed (or -1, if it's unknown).
+         */
+        Offset        lag                       = -1;
+
+        /**
+         * Number of times the batch size has been increased/decreased.
+         */
+        std::uint64_t increases                 = 0;
+        std::uint64_t decreases                 = 0;
+    };
+
+    AdaptivePollController(std::size_t minRecords, std::size_t maxRecords, std::chrono::milliseconds targetPollInterval)
+        : _minRecords(std::max<std::size_t>(std::min(minRecords, maxRecords), 1)),
+          _maxRecords(std::max<std::size_t>(maxRecords, 1)),
+          _targetPollInterval(targetPollInterval)
+    {
+        _metrics.maxPollRecords = _maxRecords;
+    }
+
+    /**
+     * Whether the batch size would be adjusted or not.
+     */
+    bool isEnabled() const { return _minRecords < _maxRecords; }
+
+    /**
+     * Decide the maximum number of records for the coming poll.
+     * `lag` is the number of records not consumed yet for all assigned partitions (or -1, if it's unknown).
+     */
+    std::size_t beforePoll(Offset lag, Clock::time_point now = Clock::now());
+
+    /**
+     * Record the number of records returned by the poll, -- the time until next poll would be taken as the processing time for them.
+     */
+    void afterPoll(std::size_t records, Clock::time_point now = Clock::now());
+
+    /**
+     * Fetch the metrics.
+     */
+    const Metrics& metrics() const { return _metrics; }
+
+private:
+    // Weight of the latest sample for the average processing time
+    static constexpr double SMOOTHING_FACTOR = 0.2;
+    // The batch size could be (at most) doubled for each poll, -- while it could be decreased immediately
+    static constexpr std::size_t MAX_GROWTH_FACTOR = 2;
+
+    const std::size_t               _minRecords;
+    const std::size_t               _maxRecords;
+    const std::chrono::milliseconds _targetPollInterval;
+
+    Clock::time_point _lastPollEnd;
+    std::size_t       _lastPolledRecords = 0;
+    bool              _hasSample         = false;
+    Metrics           _metrics;
+};
+
+inline std::size_t
+AdaptivePollController::beforePoll(Offset lag, Clock::time_point now)
+{
+    if (!isEnabled()) return _maxRecords;
+
+    // Time spent on the records returned by last poll
+    if (_lastPolledRecords > 0)
+    {
+        const double sample = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(now - _lastPollEnd).count()) / static_cast<double>(_lastPolledRecords);
+
+        _metrics.recordProcessingTimeUs = _hasSample ? (SMOOTHING_FACTOR * sample + (1 - SMOOTHING_FACTOR) * _metrics.recordProcessingTimeUs) : sample;
+        _hasSample = true;
+
+        _lastPolledRecords = 0;
+    }
+
+    _metrics.lag = lag;
+
+    // As many records as could be processed within the target interval
+    std::size_t target = _maxRecords;
+    if (_hasSample && _metrics.recordProcessingTimeUs > 0)
+    {
+        const double affordable = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(_targetPollInterval).count()) / _metrics.recordProcessingTimeUs;
+        target = (affordable < static_cast<double>(_maxRecords)) ? static_cast<std::size_t>(affordable) : _maxRecords;
+    }
+
+    // Caught up, -- no need to wait for more records than the lag
+    if (lag >= 0 && static_cast<std::uint64_t>(lag) < target)
+    {
+        target = static_cast<std::size_t>(lag);
+    }
+
+    target = std::max(target, _minRecords);
+
+    const std::size_t current = _metrics.maxPollRecords;
+    if (target > current)
+    {
+        _metrics.maxPollRecords = std::min(target, current * MAX_GROWTH_FACTOR);
+        ++_metrics.increases;
+    }
+    else if (target < current)
+    {
+        _metrics.maxPollRecords = target;
+        ++_metrics.decreases;
+    }
+
+    return _metrics.maxPollRecords;
+}
+
+inline void
+AdaptivePollController::afterPoll(std::size_t records, Clock::time_point now)
+{
+    _lastPollEnd       = now;
+    _lastPolledRecords = records;
+}
+
+} // end of KAFKA_API
+
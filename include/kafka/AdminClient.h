@@ -9,9 +9,17 @@
 
 #include "librdkafka/rdkafka.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <thread>
 #include <vector>
 
@@ -25,11 +33,43 @@ namespace Admin
  */
 using CreateTopicsResult = ErrorWithDetail;
 
+/**
+ * The specification of a new topic (for AdminClient::createTopics() with per-topic settings).
+ */
+struct NewTopicSpec
+{
+    NewTopicSpec(Topic name, int partitions, int replicas, Properties topicConfig = Properties())
+        : topic(std::move(name)), numPartitions(partitions), replicationFactor(replicas), config(std::move(topicConfig)) {}
+
+    Topic      topic;
+    int        numPartitions;
+    int        replicationFactor;
+    Properties config;
+};
+
+/**
+ * The result of AdminClient::createTopics() with per-topic settings.
+ */
+struct CreateTopicsPerTopicResult: public ErrorWithDetail
+{
+    CreateTopicsPerTopicResult(): ErrorWithDetail(RD_KAFKA_RESP_ERR_NO_ERROR, "Success") {}
+
+    /**
+     * The result for each topic.
+     */
+    std::map<Topic, ErrorWithDetail> topicResults;
+};
+
 /**
  * The result of AdminClient::deleteTopics().
  */
 using DeleteTopicsResult = ErrorWithDetail;
 
+/**
+ * The result of AdminClient::createPartitions().
+ */
+using CreatePartitionsResult = ErrorWithDetail;
+
 /**
  * The result of AdminClient::listTopics().
  */
@@ -37,11 +77,83 @@ struct ListTopicsResult: public ErrorWithDetail
 {
     ListTopicsResult(rd_kafka_resp_err_t respErr, std::string detailedMsg): ErrorWithDetail(respErr, std::move(detailedMsg)) {}
     explicit ListTopicsResult(Topics names): ErrorWithDetail(RD_KAFKA_RESP_ERR_NO_ERROR, "Success"), topics(std::move(names)) {}
+    ListTopicsResult(Topics names, std::map<Topic, int> counts)
+        : ErrorWithDetail(RD_KAFKA_RESP_ERR_NO_ERROR, "Success"), topics(std::move(names)), numPartitions(std::move(counts)) {}
 
     /**
      * The topics fetched.
      */
     Topics topics;
+
+    /**
+     * Number of partitions for each topic (from the same MetadataResponse).
+     */
+    std::map<Topic, int> numPartitions;
+};
+
+/**
+ * The result of AdminClient::listConsumerGroupOffsets().
+ */
+struct ListConsumerGroupOffsetsResult: public ErrorWithDetail
+{
+    ListConsumerGroupOffsetsResult(): ErrorWithDetail(RD_KAFKA_RESP_ERR_NO_ERROR, "Success") {}
+
+    /**
+     * The committed offsets for each group (RD_KAFKA_OFFSET_INVALID, if no offset committed for the partition, or it failed to fetch).
+     */
+    std::map<std::string, TopicPartitionOffsets> groupOffsets;
+
+    /**
+     * The partitions which failed to fetch the committed offsets (e.g, UNKNOWN_TOPIC_OR_PART), for each group.
+     */
+    std::map<std::string, std::map<TopicPartition, std::error_code>> groupPartitionErrors;
+};
+
+/**
+ * The result of AdminClient::listEndOffsets().
+ */
+struct ListEndOffsetsResult: public ErrorWithDetail
+{
+    ListEndOffsetsResult(rd_kafka_resp_err_t respErr, std::string detailedMsg): ErrorWithDetail(respErr, std::move(detailedMsg)) {}
+    explicit ListEndOffsetsResult(TopicPartitionOffsets tpos): ErrorWithDetail(RD_KAFKA_RESP_ERR_NO_ERROR, "Success"), offsets(std::move(tpos)) {}
+
+    /**
+     * The end offsets (i.e, high watermarks) for the partitions (RD_KAFKA_OFFSET_INVALID, if it failed to fetch).
+     */
+    TopicPartitionOffsets offsets;
+
+    /**
+     * The partitions which failed to fetch the end offsets (e.g, NOT_LEADER_FOR_PARTITION).
+     */
+    std::map<TopicPartition, std::error_code> partitionErrors;
+};
+
+/**
+ * The lag of a consumer group on a partition, -- the distance between the committed offset and the end offset.
+ */
+struct ConsumerGroupPartitionLag
+{
+    Offset          committed = RD_KAFKA_OFFSET_INVALID;
+    Offset          endOffset = RD_KAFKA_OFFSET_INVALID;
+    std::error_code error;      // Why the committed offset (or the end offset) is unknown, -- if it failed to fetch
+
+    /**
+     * Number of records not consumed yet (or -1, if it's unknown).
+     */
+    Offset lag() const { return (committed >= 0 && endOffset >= 0) ? std::max<Offset>(endOffset - committed, 0) : -1; }
+};
+
+/**
+ * The result of AdminClient::describeConsumerGroupLags().
+ */
+struct ConsumerGroupLagsResult: public ErrorWithDetail
+{
+    ConsumerGroupLagsResult(): ErrorWithDetail(RD_KAFKA_RESP_ERR_NO_ERROR, "Success") {}
+
+    /**
+     * The lags for each group.
+     */
+    std::map<std::string, std::map<TopicPartition, ConsumerGroupPartitionLag>> groupLags;
 };
 
 } // end of Admin
@@ -49,42 +161,200 @@ struct ListTopicsResult: public ErrorWithDetail
 
 /**
  * The administrative client for Kafka, which supports managing and inspecting topics, etc.
+ * Note: 1) The requests (e.g, CreateTopics/DeleteTopics) share one result queue, which is served by an internal thread, -- thus many of them could be in flight concurrently.
+ *       2) The callbacks (for the `*Async()` operations) are triggered by the internal thread, -- never destroy the AdminClient within a callback,
+ *          since the destructor joins the internal thread, which would then be waiting for itself (deadlock).
+ *       3) The pending operations would be completed (with RD_KAFKA_RESP_ERR__DESTROY) by the destructor, -- thus anything the callbacks refer to should outlive the AdminClient.
  */
 class AdminClient: public KafkaClient
 {
 public:
+    using CreateTopicsCallback = std::function<void(const Admin::CreateTopicsResult&)>;
+    using DeleteTopicsCallback = std::function<void(const Admin::DeleteTopicsResult&)>;
+    using CreatePartitionsCallback = std::function<void(const Admin::CreatePartitionsResult&)>;
+
     explicit AdminClient(const Properties& properties)
-        : KafkaClient(ClientType::AdminClient, KafkaClient::validateAndReformProperties(properties))
+        : KafkaClient(ClientType::AdminClient, KafkaClient::validateAndReformProperties(properties)),
+          _rk_queue(rd_kafka_queue_new(getClientHandle()))
+    {
+        _pollable   = std::make_unique<KafkaClient::PollableCallback<AdminClient>>(this, pollCallbacks);
+        _pollThread = std::make_unique<PollThread>(*_pollable);
+    }
+
+    ~AdminClient() override
     {
+        _pollThread.reset(); // Join the dispatching thread
+        _pollable.reset();
+
+        stopBrokerMetadataCache();
+
+        abortPendingOperations();
     }
 
     /**
      * Create a batch of new topics.
+     * Note: It returns after every partition of the new topics has got a leader (or the timeout expires).
      */
     Admin::CreateTopicsResult createTopics(const Topics& topics, int numPartitions, int replicationFactor,
                                            const Properties& topicConfig = Properties(),
                                            std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+    /**
+     * Create a batch of new topics, each with its own settings.
+     * The topics would be split into several CreateTopics requests (with a bounded number of topics), which are all sent at once.
+     * Note: 1) It returns after every partition of the new topics has got a leader (or the timeout expires), with the result for each topic.
+     *       2) Only the partition count, the replication factor, and the duplicated topic names are checked locally,
+     *          -- an invalid one would fail the topic (with RD_KAFKA_RESP_ERR__INVALID_ARG) without being sent. The others (e.g, the topic name, or the configs) would be checked by the brokers.
+     */
+    Admin::CreateTopicsPerTopicResult createTopics(const std::vector<Admin::NewTopicSpec>& specs,
+                                                   std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
     /**
      * Delete a batch of topics.
      */
     Admin::DeleteTopicsResult deleteTopics(const Topics& topics,
                                            std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+
+    /**
+     * Create a batch of new topics, without waiting for the result.
+     * Note: 1) The callback would be triggered by the internal thread (or within the call, if the arguments are invalid), and it must not block.
+     *       2) The partition leaders might not be elected yet while the result arrives, -- see `waitForTopicsReady()`.
+     */
+    void createTopicsAsync(const Topics& topics, int numPartitions, int replicationFactor,
+                           const Properties&         topicConfig,
+                           std::chrono::milliseconds timeout,
+                           CreateTopicsCallback      cb);
+
+    std::future<Admin::CreateTopicsResult> createTopicsAsync(const Topics& topics, int numPartitions, int replicationFactor,
+                                                             const Properties& topicConfig = Properties(),
+                                                             std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+    /**
+     * Delete a batch of topics, without waiting for the result.
+     * Note: The callback would be triggered by the internal thread, and it must not block.
+     */
+    void deleteTopicsAsync(const Topics& topics, std::chrono::milliseconds timeout, DeleteTopicsCallback cb);
+
+    std::future<Admin::DeleteTopicsResult> deleteTopicsAsync(const Topics& topics,
+                                                             std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+    /**
+     * Increase the number of partitions for a batch of topics (with the new total counts), -- with a single CreatePartitions request.
+     * Note: The producers would not send records to the new partitions until their metadata get refreshed, -- see `KafkaClient::refreshBrokerMetadata()`,
+     *       or use the overload with the clients to refresh.
+     */
+    Admin::CreatePartitionsResult createPartitions(const std::map<Topic, int>& newTotalCounts,
+                                                   std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+    /**
+     * Increase the number of partitions for a batch of topics, and then refresh the metadata of these clients (e.g, the producers),
+     *   -- once it returns with success, they could send records to the new partitions (instead of waiting for the periodic refresh with "topic.metadata.refresh.interval.ms").
+     * Note: 1) It waits for the new partitions to get the leaders, and for every client to see the new partition counts (or the timeout expires).
+     *       2) The clients must outlive the call.
+     */
+    Admin::CreatePartitionsResult createPartitions(const std::map<Topic, int>& newTotalCounts,
+                                                   const std::vector<std::reference_wrapper<KafkaClient>>& clientsToRefresh,
+                                                   std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+
+    /**
+     * Increase the number of partitions for a batch of topics, without waiting for the result.
+     * Note: The callback would be triggered by the internal thread (or within the call, if the arguments are invalid), and it must not block.
+     */
+    void createPartitionsAsync(const std::map<Topic, int>& newTotalCounts, std::chrono::milliseconds timeout, CreatePartitionsCallback cb);
+
+    std::future<Admin::CreatePartitionsResult> createPartitionsAsync(const std::map<Topic, int>& newTotalCounts,
+                                                                     std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+
+    /**
+     * Fetch the committed offsets of the consumer groups for the partitions, -- without joining the groups.
+     * Note: With librdkafka 1.6.0 (which doesn't have the ListConsumerGroupOffsets API), each group is served with a temporary consumer handle (never subscribing),
+     *       which sends one OffsetFetch request for all the partitions, and a few groups are served concurrently.
+     */
+    Admin::ListConsumerGroupOffsetsResult listConsumerGroupOffsets(const std::set<std::string>& groups,
+                                                                   const TopicPartitions& tps,
+                                                                   std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+
+    /**
+     * Fetch the end offsets (i.e, high watermarks) for the partitions, -- with ListOffsets requests batched by the partition leaders.
+     */
+    Admin::ListEndOffsetsResult   listEndOffsets(const TopicPartitions& tps,
+                                                 std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+
+    /**
+     * Report the lags of the consumer groups for the partitions, -- with the end offsets fetched once for all groups.
+     */
+    Admin::ConsumerGroupLagsResult describeConsumerGroupLags(const std::set<std::string>& groups,
+                                                             const TopicPartitions& tps,
+                                                             std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+
+    /**
+     * Wait until every partition of the topics has got a leader, -- with MetadataRequests only for these topics (retried with exponential backoff).
+     */
+    ErrorWithDetail           waitForTopicsReady(const Topics& topics,
+                                                 std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+
     /**
      * List the topics available in the cluster.
      */
     Admin::ListTopicsResult   listTopics(std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
 
+    /**
+     * List the topics (within the specified ones) available in the cluster, -- with a MetadataRequest only for these topics (instead of the full cluster).
+     */
+    Admin::ListTopicsResult   listTopics(const Topics& topics,
+                                         std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_COMMAND_TIMEOUT_MS));
+
 private:
+    // Completes a pending operation with the result event (or nullptr, if it's aborted)
+    using EventHandler = std::function<void(rd_kafka_event_t*)>;
+
     static std::list<ErrorWithDetail> getPerTopicResults(const rd_kafka_topic_result_t** topicResults, int topicCount);
     static ErrorWithDetail            combineErrors(const std::list<ErrorWithDetail>& errors);
 
+    // Send a MetadataRequest (for all topics, or for the specified ones), and collect the existing topics with their partition counts
+    Admin::ListTopicsResult           listTopicsWithMetadata(const Topics* topics, std::chrono::milliseconds timeout);
+
+    // Prepare the options (with the timeout, and a unique id as the opaque) for a request, and register the handler for its result
+    rd_kafka_AdminOptions_unique_ptr  prepareOperation(rd_kafka_admin_op_t op, std::chrono::milliseconds timeout, EventHandler handler);
+
+    // Check (with one MetadataRequest) whether every partition of the topics has a leader, -- the detail tells what's not ready yet
+    ErrorWithDetail                   checkTopicsReady(const Topics& topics, std::chrono::milliseconds timeout);
+
+    // Construct the NewTopic (or nullptr, with the error message filled), -- librdkafka only checks the partition count and replication factor
+    rd_kafka_NewTopic_unique_ptr      newTopic(const Admin::NewTopicSpec& spec, std::string& errMsg) const;
+
+    // The result for each topic within a CreateTopics result event (or nullptr, if it's aborted)
+    static std::map<Topic, ErrorWithDetail> getPerTopicCreateResults(rd_kafka_event_t* rk_ev, const Topics& topics);
+
+    // Fetch the committed offsets of a consumer group, -- with a temporary consumer handle (which never joins the group)
+    ErrorWithDetail                   fetchCommittedOffsets(const std::string& group, const TopicPartitions& tps, std::chrono::milliseconds timeout,
+                                                            TopicPartitionOffsets& offsets, std::map<TopicPartition, std::error_code>& partitionErrors);
+
+    // Errors (for the whole request, and for each topic) within a CreateTopics/DeleteTopics/CreatePartitions result event
+    static ErrorWithDetail            getTopicsResult(rd_kafka_event_t* rk_ev);
+
+    static void pollCallbacks(AdminClient* client, int timeoutMs) { client->dispatchEvents(timeoutMs); }
+
+    void dispatchEvents(int timeoutMs);
+    void abortPendingOperations();
+
 #if __cplusplus >= 201703L
     static constexpr int DEFAULT_COMMAND_TIMEOUT_MS = 30000;
-    static constexpr int EVENT_POLLING_INTERVAL_MS  = 100;
+    static constexpr int READINESS_MIN_BACKOFF_MS   = 50;
+    static constexpr int READINESS_MAX_BACKOFF_MS   = 1000;
+    static constexpr int MAX_TOPICS_PER_REQUEST     = 100;
+    static constexpr int MAX_CONCURRENT_GROUPS      = 8;
 #else
     enum { DEFAULT_COMMAND_TIMEOUT_MS = 30000 };
-    enum { EVENT_POLLING_INTERVAL_MS  = 100   };
+    enum { READINESS_MIN_BACKOFF_MS   = 50    };
+    enum { READINESS_MAX_BACKOFF_MS   = 1000  };
+    enum { MAX_TOPICS_PER_REQUEST     = 100   };
+    enum { MAX_CONCURRENT_GROUPS      = 8     };
 #endif
+
+    rd_kafka_queue_unique_ptr                _rk_queue;
+
+    std::mutex                               _operationsLock;
+    std::map<std::uintptr_t, EventHandler>   _pendingOperations;
+    std::uintptr_t                           _nextOperationId = 1;
+
+    std::unique_ptr<Pollable>                _pollable;
+    std::unique_ptr<KafkaClient::PollThread> _pollThread;
 };
 
 
@@ -124,172 +394,803 @@ AdminClient::combineErrors(const std::list<ErrorWithDetail>& errors)
     return ErrorWithDetail(RD_KAFKA_RESP_ERR_NO_ERROR, "Success");
 }
 
-inline Admin::CreateTopicsResult
-AdminClient::createTopics(const Topics& topics, int numPartitions, int replicationFactor,
-                          const Properties& topicConfig,
-                          std::chrono::milliseconds timeout)
+inline rd_kafka_AdminOptions_unique_ptr
+AdminClient::prepareOperation(rd_kafka_admin_op_t op, std::chrono::milliseconds timeout, EventHandler handler)
 {
+    auto rk_options = rd_kafka_AdminOptions_unique_ptr(rd_kafka_AdminOptions_new(getClientHandle(), op));
+
+    // The request would be completed (with an error) by librdkafka after the timeout, -- thus the handler would always be triggered
     LogBuffer<500> errInfo;
+    if (rd_kafka_AdminOptions_set_request_timeout(rk_options.get(), convertMsDurationToInt(timeout), errInfo.str(), errInfo.capacity()) != RD_KAFKA_RESP_ERR_NO_ERROR)
+    {
+        KAFKA_API_DO_LOG(LOG_ERR, "failed to set request timeout for admin operation! error[%s]", errInfo.c_str());
+    }
 
-    std::vector<rd_kafka_NewTopic_unique_ptr> rkNewTopics;
+    std::lock_guard<std::mutex> lock(_operationsLock);
 
-    for (const auto& topic: topics)
+    const std::uintptr_t id = _nextOperationId++;
+    _pendingOperations.emplace(id, std::move(handler));
+    rd_kafka_AdminOptions_set_opaque(rk_options.get(), reinterpret_cast<void*>(id)); // NOLINT
+
+    return rk_options;
+}
+
+inline void
+AdminClient::dispatchEvents(int timeoutMs)
+{
+    auto rk_ev = rd_kafka_event_unique_ptr(rd_kafka_queue_poll(_rk_queue.get(), timeoutMs));
+    if (!rk_ev) return;
+
+    EventHandler handler;
     {
-        rkNewTopics.emplace_back(rd_kafka_NewTopic_new(topic.c_str(), numPartitions, replicationFactor, errInfo.str(), errInfo.capacity()));
-        if (!rkNewTopics.back())
+        std::lock_guard<std::mutex> lock(_operationsLock);
+
+        auto it = _pendingOperations.find(reinterpret_cast<std::uintptr_t>(rd_kafka_event_opaque(rk_ev.get()))); // NOLINT
+        if (it != _pendingOperations.end())
         {
-            return Admin::CreateTopicsResult(RD_KAFKA_RESP_ERR__INVALID_ARG, rd_kafka_err2str(RD_KAFKA_RESP_ERR__INVALID_ARG));
+            handler = std::move(it->second);
+            _pendingOperations.erase(it);
         }
+    }
 
-        for (const auto& conf: topicConfig.map())
+    if (!handler)
+    {
+        KAFKA_API_DO_LOG(LOG_INFO, "rd_kafka_queue_poll got event[%s], with error[%s]", rd_kafka_event_name(rk_ev.get()), rd_kafka_event_error_string(rk_ev.get()));
+        return;
+    }
+
+    handler(rk_ev.get());
+}
+
+inline void
+AdminClient::abortPendingOperations()
+{
+    std::map<std::uintptr_t, EventHandler> pendingOperations;
+    {
+        std::lock_guard<std::mutex> lock(_operationsLock);
+        pendingOperations.swap(_pendingOperations);
+    }
+
+    for (auto& operation: pendingOperations)
+    {
+        operation.second(nullptr);
+    }
+}
+
+inline ErrorWithDetail
+AdminClient::getTopicsResult(rd_kafka_event_t* rk_ev)
+{
+    if (!rk_ev)
+    {
+        return ErrorWithDetail(RD_KAFKA_RESP_ERR__DESTROY, "The AdminClient was destroyed before the response arrived");
+    }
+
+    std::list<ErrorWithDetail> errors;
+
+    if (rd_kafka_resp_err_t respErr = rd_kafka_event_error(rk_ev))
+    {
+        errors.emplace_back(respErr, rd_kafka_event_error_string(rk_ev));
+    }
+
+    // Fetch per-topic results
+    std::size_t res_topic_cnt{};
+    const rd_kafka_topic_result_t** res_topics = nullptr;
+    switch (rd_kafka_event_type(rk_ev))
+    {
+        case RD_KAFKA_EVENT_CREATETOPICS_RESULT:
+            res_topics = rd_kafka_CreateTopics_result_topics(rd_kafka_event_CreateTopics_result(rk_ev), &res_topic_cnt);
+            break;
+        case RD_KAFKA_EVENT_DELETETOPICS_RESULT:
+            res_topics = rd_kafka_DeleteTopics_result_topics(rd_kafka_event_DeleteTopics_result(rk_ev), &res_topic_cnt);
+            break;
+        case RD_KAFKA_EVENT_CREATEPARTITIONS_RESULT:
+            res_topics = rd_kafka_CreatePartitions_result_topics(rd_kafka_event_CreatePartitions_result(rk_ev), &res_topic_cnt);
+            break;
+        default:
+            break;
+    }
+
+    errors.splice(errors.end(), getPerTopicResults(res_topics, static_cast<int>(res_topic_cnt)));
+
+    return combineErrors(errors);
+}
+
+inline rd_kafka_NewTopic_unique_ptr
+AdminClient::newTopic(const Admin::NewTopicSpec& spec, std::string& errMsg) const
+{
+    LogBuffer<500> errInfo;
+
+    auto rkNewTopic = rd_kafka_NewTopic_unique_ptr(rd_kafka_NewTopic_new(spec.topic.c_str(), spec.numPartitions, spec.replicationFactor, errInfo.str(), errInfo.capacity()));
+    if (!rkNewTopic)
+    {
+        errMsg = "Invalid topic[" + spec.topic + "], " + errInfo.c_str();
+        return rkNewTopic;
+    }
+
+    for (const auto& conf: spec.config.map())
+    {
+        rd_kafka_resp_err_t err = rd_kafka_NewTopic_set_config(rkNewTopic.get(), conf.first.c_str(), conf.second.c_str());
+        if (err != RD_KAFKA_RESP_ERR_NO_ERROR)
         {
-            rd_kafka_resp_err_t err = rd_kafka_NewTopic_set_config(rkNewTopics.back().get(), conf.first.c_str(), conf.second.c_str());
-            if (err != RD_KAFKA_RESP_ERR_NO_ERROR)
+            errMsg = "Invalid config[" + conf.first + "=" + conf.second + "]";
+            KAFKA_API_DO_LOG(LOG_ERR, errMsg.c_str());
+            return nullptr;
+        }
+    }
+
+    return rkNewTopic;
+}
+
+inline std::map<Topic, ErrorWithDetail>
+AdminClient::getPerTopicCreateResults(rd_kafka_event_t* rk_ev, const Topics& topics)
+{
+    std::map<Topic, ErrorWithDetail> results;
+
+    if (!rk_ev)
+    {
+        for (const auto& topic: topics)
+        {
+            results.emplace(topic, ErrorWithDetail(RD_KAFKA_RESP_ERR__DESTROY, "The AdminClient was destroyed before the response arrived"));
+        }
+        return results;
+    }
+
+    if (const rd_kafka_CreateTopics_result_t* res = rd_kafka_event_CreateTopics_result(rk_ev))
+    {
+        std::size_t res_topic_cnt{};
+        const rd_kafka_topic_result_t** res_topics = rd_kafka_CreateTopics_result_topics(res, &res_topic_cnt);
+
+        for (std::size_t i = 0; i < res_topic_cnt; ++i)
+        {
+            const std::string topic = rd_kafka_topic_result_name(res_topics[i]);
+            if (rd_kafka_resp_err_t topicError = rd_kafka_topic_result_error(res_topics[i]))
+            {
+                results.emplace(topic, ErrorWithDetail(topicError, "topic[" + topic + "] with error[" + rd_kafka_topic_result_error_string(res_topics[i]) + "]"));
+            }
+            else
             {
-                std::string errMsg = "Invalid config[" + conf.first + "=" + conf.second + "]";
-                KAFKA_API_DO_LOG(LOG_ERR, errMsg.c_str());
-                return Admin::CreateTopicsResult(RD_KAFKA_RESP_ERR__INVALID_ARG, errMsg);
+                results.emplace(topic, ErrorWithDetail(RD_KAFKA_RESP_ERR_NO_ERROR, "Success"));
             }
         }
     }
 
+    // The topics with no result, -- e.g, the whole request failed
+    const rd_kafka_resp_err_t respErr = rd_kafka_event_error(rk_ev);
+    for (const auto& topic: topics)
+    {
+        if (results.count(topic)) continue;
+
+        results.emplace(topic, respErr ? ErrorWithDetail(respErr, rd_kafka_event_error_string(rk_ev))
+                                       : ErrorWithDetail(RD_KAFKA_RESP_ERR__FAIL, "No result for topic[" + topic + "]"));
+    }
+
+    return results;
+}
+
+inline void
+AdminClient::createTopicsAsync(const Topics& topics, int numPartitions, int replicationFactor,
+                               const Properties&         topicConfig,
+                               std::chrono::milliseconds timeout,
+                               CreateTopicsCallback      cb)
+{
+    std::vector<rd_kafka_NewTopic_unique_ptr> rkNewTopics;
+
+    for (const auto& topic: topics)
+    {
+        std::string errMsg;
+        rkNewTopics.emplace_back(newTopic(Admin::NewTopicSpec(topic, numPartitions, replicationFactor, topicConfig), errMsg));
+        if (!rkNewTopics.back())
+        {
+            cb(Admin::CreateTopicsResult(RD_KAFKA_RESP_ERR__INVALID_ARG, errMsg));
+            return;
+        }
+    }
+
     std::vector<rd_kafka_NewTopic_t*> rk_topics;
     rk_topics.reserve(rkNewTopics.size());
     for (const auto& topic : rkNewTopics) { rk_topics.emplace_back(topic.get()); }
 
-    auto rk_queue = rd_kafka_queue_unique_ptr(rd_kafka_queue_new(getClientHandle()));
+    auto rk_options = prepareOperation(RD_KAFKA_ADMIN_OP_CREATETOPICS, timeout,
+                                       [cb](rd_kafka_event_t* rk_ev) { cb(getTopicsResult(rk_ev)); });
+
+    rd_kafka_CreateTopics(getClientHandle(), rk_topics.data(), rk_topics.size(), rk_options.get(), _rk_queue.get());
+}
+
+inline std::future<Admin::CreateTopicsResult>
+AdminClient::createTopicsAsync(const Topics& topics, int numPartitions, int replicationFactor,
+                               const Properties& topicConfig,
+                               std::chrono::milliseconds timeout)
+{
+    auto promise = std::make_shared<std::promise<Admin::CreateTopicsResult>>();
+    auto future  = promise->get_future();
+
+    createTopicsAsync(topics, numPartitions, replicationFactor, topicConfig, timeout,
+                      [promise](const Admin::CreateTopicsResult& result) { promise->set_value(result); });
+
+    return future;
+}
+
+inline void
+AdminClient::deleteTopicsAsync(const Topics& topics, std::chrono::milliseconds timeout, DeleteTopicsCallback cb)
+{
+    std::vector<rd_kafka_DeleteTopic_unique_ptr> rkDeleteTopics;
+
+    for (const auto& topic: topics)
+    {
+        rkDeleteTopics.emplace_back(rd_kafka_DeleteTopic_new(topic.c_str()));
+        assert(rkDeleteTopics.back());
+    }
+
+    std::vector<rd_kafka_DeleteTopic_t*> rk_topics;
+    rk_topics.reserve(rkDeleteTopics.size());
+    for (const auto& topic : rkDeleteTopics) { rk_topics.emplace_back(topic.get()); }
 
-    rd_kafka_CreateTopics(getClientHandle(), rk_topics.data(), rk_topics.size(), nullptr, rk_queue.get());
+    auto rk_options = prepareOperation(RD_KAFKA_ADMIN_OP_DELETETOPICS, timeout,
+                                       [cb](rd_kafka_event_t* rk_ev) { cb(getTopicsResult(rk_ev)); });
 
-    auto rk_ev = rd_kafka_event_unique_ptr();
+    rd_kafka_DeleteTopics(getClientHandle(), rk_topics.data(), rk_topics.size(), rk_options.get(), _rk_queue.get());
+}
 
+inline std::future<Admin::DeleteTopicsResult>
+AdminClient::deleteTopicsAsync(const Topics& topics, std::chrono::milliseconds timeout)
+{
+    auto promise = std::make_shared<std::promise<Admin::DeleteTopicsResult>>();
+    auto future  = promise->get_future();
+
+    deleteTopicsAsync(topics, timeout, [promise](const Admin::DeleteTopicsResult& result) { promise->set_value(result); });
+
+    return future;
+}
+
+inline Admin::CreateTopicsResult
+AdminClient::createTopics(const Topics& topics, int numPartitions, int replicationFactor,
+                          const Properties& topicConfig,
+                          std::chrono::milliseconds timeout)
+{
     const auto end = std::chrono::steady_clock::now() + timeout;
-    do
+
+    auto future = createTopicsAsync(topics, numPartitions, replicationFactor, topicConfig, timeout);
+    if (future.wait_until(end) != std::future_status::ready)
     {
-        rk_ev.reset(rd_kafka_queue_poll(rk_queue.get(), EVENT_POLLING_INTERVAL_MS));
+        return Admin::CreateTopicsResult(RD_KAFKA_RESP_ERR__TIMED_OUT, "No response within the time limit");
+    }
+
+    auto result = future.get();
 
-        if (rd_kafka_event_type(rk_ev.get()) == RD_KAFKA_EVENT_CREATETOPICS_RESULT) break;
+    // Return the error if any
+    if (result.error)
+    {
+        return result;
+    }
+
+    // Wait for the partition leaders
+    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(end - std::chrono::steady_clock::now());
+    return waitForTopicsReady(topics, std::max(remaining, std::chrono::milliseconds(0)));
+}
 
-        if (rk_ev)
+inline ErrorWithDetail
+AdminClient::fetchCommittedOffsets(const std::string& group, const TopicPartitions& tps, std::chrono::milliseconds timeout,
+                                   TopicPartitionOffsets& offsets, std::map<TopicPartition, std::error_code>& partitionErrors)
+{
+    LogBuffer<500> errInfo;
+
+    auto rk_conf = rd_kafka_conf_unique_ptr(rd_kafka_conf_new());
+
+    // Same properties as the AdminClient (e.g, for the security settings), -- the private ones (only for the C++ wrapper) would be ignored
+    std::string ignored;
+    for (const auto& prop: properties().map())
+    {
+        if (rd_kafka_conf_set(rk_conf.get(), prop.first.c_str(), prop.second.c_str(), errInfo.clear().str(), errInfo.capacity()) != RD_KAFKA_CONF_OK)
         {
-            KAFKA_API_DO_LOG(LOG_INFO, "rd_kafka_queue_poll got event[%s], with error[%s]", rd_kafka_event_name(rk_ev.get()), rd_kafka_event_error_string(rk_ev.get()));
-            rk_ev.reset();
+            ignored.append(ignored.empty() ? "" : ",").append(prop.first);
         }
-    } while (std::chrono::steady_clock::now() < end);
+    }
+    if (!ignored.empty())
+    {
+        KAFKA_API_DO_LOG(LOG_INFO, "properties[%s] ignored for the handle of group[%s]", ignored.c_str(), group.c_str());
+    }
 
-    if (!rk_ev)
+    if (rd_kafka_conf_set(rk_conf.get(), "group.id", group.c_str(), errInfo.clear().str(), errInfo.capacity()) != RD_KAFKA_CONF_OK
+        || rd_kafka_conf_set(rk_conf.get(), "enable.auto.commit", "false", errInfo.clear().str(), errInfo.capacity()) != RD_KAFKA_CONF_OK)
     {
-        return Admin::CreateTopicsResult(RD_KAFKA_RESP_ERR__TIMED_OUT, "No response within the time limit");
+        return ErrorWithDetail(RD_KAFKA_RESP_ERR__INVALID_ARG, std::string("Invalid group[") + group + "], " + errInfo.c_str());
     }
 
-    std::list<ErrorWithDetail> errors;
+    // Log with the AdminClient
+    rd_kafka_conf_set_opaque(rk_conf.get(), this);
+    rd_kafka_conf_set_log_cb(rk_conf.get(), KafkaClient::logCallback);
 
-    if (rd_kafka_resp_err_t respErr = rd_kafka_event_error(rk_ev.get()))
+    auto rk = rd_kafka_unique_ptr(rd_kafka_new(RD_KAFKA_CONSUMER, rk_conf.get(), errInfo.clear().str(), errInfo.capacity()));
+    if (!rk)
     {
-        errors.emplace_back(respErr, rd_kafka_event_error_string(rk_ev.get()));
+        return ErrorWithDetail(RD_KAFKA_RESP_ERR__CRIT_SYS_RESOURCE, std::string("Failed to create handle for group[") + group + "], " + errInfo.c_str());
     }
+    rk_conf.release(); // rk_conf's ownship has been transferred to rk
 
-    // Fetch per-topic results
-    const rd_kafka_CreateTopics_result_t* res = rd_kafka_event_CreateTopics_result(rk_ev.get());
-    std::size_t res_topic_cnt{};
-    const rd_kafka_topic_result_t** res_topics = rd_kafka_CreateTopics_result_topics(res, &res_topic_cnt);
+    auto rk_tps = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList(tps));
 
-    errors.splice(errors.end(), getPerTopicResults(res_topics, res_topic_cnt));
+    rd_kafka_resp_err_t err = rd_kafka_committed(rk.get(), rk_tps.get(), convertMsDurationToInt(timeout));
+    if (err != RD_KAFKA_RESP_ERR_NO_ERROR)
+    {
+        return ErrorWithDetail(err, "group[" + group + "] with error[" + rd_kafka_err2str(err) + "]");
+    }
 
-    // Return the error if any
-    if (!errors.empty())
+    for (int i = 0; i < rk_tps->cnt; ++i)
     {
-        return combineErrors(errors);
+        const rd_kafka_topic_partition_t& rk_tpo = rk_tps->elems[i];
+        const TopicPartition tp(rk_tpo.topic, rk_tpo.partition);
+
+        offsets.emplace(tp, rk_tpo.err ? RD_KAFKA_OFFSET_INVALID : rk_tpo.offset);
+        if (rk_tpo.err) partitionErrors.emplace(tp, ErrorCode(rk_tpo.err));
     }
+    return ErrorWithDetail(RD_KAFKA_RESP_ERR_NO_ERROR, "Success");
+}
+
+inline Admin::ListConsumerGroupOffsetsResult
+AdminClient::listConsumerGroupOffsets(const std::set<std::string>& groups, const TopicPartitions& tps, std::chrono::milliseconds timeout)
+{
+    const auto end = std::chrono::steady_clock::now() + timeout;
+
+    const std::vector<std::string> groupList(groups.cbegin(), groups.cend());
+
+    std::vector<TopicPartitionOffsets>                     offsets(groupList.size());
+    std::vector<std::map<TopicPartition, std::error_code>> partitionErrors(groupList.size());
+    std::vector<ErrorWithDetail>                           errors(groupList.size(), ErrorWithDetail(RD_KAFKA_RESP_ERR_NO_ERROR, "Success"));
+
+    // A few workers, each takes the next group (with an index)
+    std::atomic<std::size_t> next(0);
+    auto worker = [&]() {
+        for (std::size_t i = next++; i < groupList.size(); i = next++)
+        {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(end - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0)
+            {
+                errors[i] = ErrorWithDetail(RD_KAFKA_RESP_ERR__TIMED_OUT, "group[" + groupList[i] + "] not served within the time limit");
+                continue;
+            }
 
-    // Update metedata
-    do
+            errors[i] = fetchCommittedOffsets(groupList[i], tps, remaining, offsets[i], partitionErrors[i]);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const std::size_t numWorkers = std::min<std::size_t>(groupList.size(), MAX_CONCURRENT_GROUPS);
+    for (std::size_t i = 0; i < numWorkers; ++i) workers.emplace_back(worker);
+    for (auto& thread: workers) thread.join();
+
+    Admin::ListConsumerGroupOffsetsResult ret;
+    for (std::size_t i = 0; i < groupList.size(); ++i)
     {
-        auto listResult = listTopics();
-        if (!listResult.error)
+        if (errors[i].error)
         {
-            return Admin::CreateTopicsResult(RD_KAFKA_RESP_ERR_NO_ERROR, "Success");
+            KAFKA_API_DO_LOG(LOG_ERR, "failed to fetch committed offsets: %s", errors[i].detail.c_str());
+            if (!ret.error) static_cast<ErrorWithDetail&>(ret) = errors[i];
+            continue;
         }
-    } while (std::chrono::steady_clock::now() < end);
 
-    return Admin::CreateTopicsResult(RD_KAFKA_RESP_ERR__TIMED_OUT, "Updating metadata timed out");
+        ret.groupOffsets.emplace(groupList[i], std::move(offsets[i]));
+        if (!partitionErrors[i].empty()) ret.groupPartitionErrors.emplace(groupList[i], std::move(partitionErrors[i]));
+    }
+    return ret;
 }
 
-inline Admin::DeleteTopicsResult
-AdminClient::deleteTopics(const Topics& topics, std::chrono::milliseconds timeout)
+inline Admin::ListEndOffsetsResult
+AdminClient::listEndOffsets(const TopicPartitions& tps, std::chrono::milliseconds timeout)
 {
-    std::vector<rd_kafka_DeleteTopic_unique_ptr> rkDeleteTopics;
+    TopicPartitionOffsets tpos;
+    for (const auto& tp: tps) tpos.emplace(tp, RD_KAFKA_OFFSET_END);
 
-    for (const auto& topic: topics)
+    auto rk_tpos = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList(tpos));
+
+    // The "latest" timestamp means the end offsets
+    rd_kafka_resp_err_t err = rd_kafka_offsets_for_times(getClientHandle(), rk_tpos.get(), convertMsDurationToInt(timeout));
+    if (err != RD_KAFKA_RESP_ERR_NO_ERROR)
     {
-        rkDeleteTopics.emplace_back(rd_kafka_DeleteTopic_new(topic.c_str()));
-        assert(rkDeleteTopics.back());
+        return Admin::ListEndOffsetsResult(err, rd_kafka_err2str(err));
     }
 
-    std::vector<rd_kafka_DeleteTopic_t*> rk_topics;
-    rk_topics.reserve(rkDeleteTopics.size());
-    for (const auto& topic : rkDeleteTopics) { rk_topics.emplace_back(topic.get()); }
+    TopicPartitionOffsets                     offsets;
+    std::map<TopicPartition, std::error_code> partitionErrors;
+    for (int i = 0; i < rk_tpos->cnt; ++i)
+    {
+        const rd_kafka_topic_partition_t& rk_tpo = rk_tpos->elems[i];
+        const TopicPartition tp(rk_tpo.topic, rk_tpo.partition);
+
+        offsets.emplace(tp, rk_tpo.err ? RD_KAFKA_OFFSET_INVALID : rk_tpo.offset);
+        if (rk_tpo.err) partitionErrors.emplace(tp, ErrorCode(rk_tpo.err));
+    }
+
+    Admin::ListEndOffsetsResult ret(std::move(offsets));
+    ret.partitionErrors = std::move(partitionErrors);
+    return ret;
+}
+
+inline Admin::ConsumerGroupLagsResult
+AdminClient::describeConsumerGroupLags(const std::set<std::string>& groups, const TopicPartitions& tps, std::chrono::milliseconds timeout)
+{
+    // The committed offsets are fetched (by other threads) while the end offsets are being fetched
+    auto committedFuture = std::async(std::launch::async, [this, &groups, &tps, timeout]() { return listConsumerGroupOffsets(groups, tps, timeout); });
+
+    auto endOffsetsResult = listEndOffsets(tps, timeout);
+    auto committedResult  = committedFuture.get();
+
+    Admin::ConsumerGroupLagsResult ret;
+    if (endOffsetsResult.error)       static_cast<ErrorWithDetail&>(ret) = endOffsetsResult;
+    else if (committedResult.error)   static_cast<ErrorWithDetail&>(ret) = committedResult;
+
+    for (const auto& groupOffsets: committedResult.groupOffsets)
+    {
+        auto& lags = ret.groupLags[groupOffsets.first];
+
+        auto groupErrorsIt = committedResult.groupPartitionErrors.find(groupOffsets.first);
+        const std::map<TopicPartition, std::error_code>* groupErrors = (groupErrorsIt != committedResult.groupPartitionErrors.end()) ? &groupErrorsIt->second : nullptr;
+
+        for (const auto& tpo: groupOffsets.second)
+        {
+            Admin::ConsumerGroupPartitionLag lag;
+            lag.committed = tpo.second;
+
+            auto it = endOffsetsResult.offsets.find(tpo.first);
+            if (it != endOffsetsResult.offsets.end()) lag.endOffset = it->second;
+
+            auto errIt = endOffsetsResult.partitionErrors.find(tpo.first);
+            if (errIt != endOffsetsResult.partitionErrors.end())
+            {
+                lag.error = errIt->second;
+            }
+            else if (groupErrors && groupErrors->count(tpo.first))
+            {
+                lag.error = groupErrors->at(tpo.first);
+            }
+
+            lags.emplace(tpo.first, lag);
+        }
+    }
+    return ret;
+}
 
-    auto rk_queue = rd_kafka_queue_unique_ptr(rd_kafka_queue_new(getClientHandle()));
+inline ErrorWithDetail
+AdminClient::checkTopicsReady(const Topics& topics, std::chrono::milliseconds timeout)
+{
+    const TopicsMetadata topicsMetadata = fetchTopicsMetadata(&topics, timeout);
+    if (topicsMetadata.error != RD_KAFKA_RESP_ERR_NO_ERROR)
+    {
+        return ErrorWithDetail(topicsMetadata.error, rd_kafka_err2str(topicsMetadata.error));
+    }
+
+    Topics readyTopics;
+    for (const auto* topicMetadata: topicsMetadata.topics)
+    {
+        const rd_kafka_metadata_topic& metadata_topic = *topicMetadata;
+
+        if (metadata_topic.err != RD_KAFKA_RESP_ERR_NO_ERROR)
+        {
+            return ErrorWithDetail(metadata_topic.err, "topic[" + std::string(metadata_topic.topic) + "] with error[" + rd_kafka_err2str(metadata_topic.err) + "]");
+        }
+
+        for (int j = 0; j < metadata_topic.partition_cnt; ++j)
+        {
+            const rd_kafka_metadata_partition& metadata_partition = metadata_topic.partitions[j];
+            if (metadata_partition.err != RD_KAFKA_RESP_ERR_NO_ERROR || metadata_partition.leader < 0)
+            {
+                return ErrorWithDetail(RD_KAFKA_RESP_ERR_LEADER_NOT_AVAILABLE,
+                                       "topic[" + std::string(metadata_topic.topic) + "]-partition[" + std::to_string(metadata_partition.id) + "] with no leader");
+            }
+        }
 
-    rd_kafka_DeleteTopics(getClientHandle(), rk_topics.data(), rk_topics.size(), nullptr, rk_queue.get());
+        if (metadata_topic.partition_cnt > 0) readyTopics.emplace(metadata_topic.topic);
+    }
 
-    auto rk_ev = rd_kafka_event_unique_ptr();
+    if (readyTopics.size() != topics.size())
+    {
+        return ErrorWithDetail(RD_KAFKA_RESP_ERR_UNKNOWN_TOPIC_OR_PART, "No metadata for some topics yet");
+    }
 
+    return ErrorWithDetail(RD_KAFKA_RESP_ERR_NO_ERROR, "Success");
+}
+
+inline ErrorWithDetail
+AdminClient::waitForTopicsReady(const Topics& topics, std::chrono::milliseconds timeout)
+{
     const auto end = std::chrono::steady_clock::now() + timeout;
-    do
+
+    auto backoff = std::chrono::milliseconds(READINESS_MIN_BACKOFF_MS);
+    for (;;)
     {
-        rk_ev.reset(rd_kafka_queue_poll(rk_queue.get(), EVENT_POLLING_INTERVAL_MS));
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(end - std::chrono::steady_clock::now());
 
-        if (rd_kafka_event_type(rk_ev.get()) == RD_KAFKA_EVENT_DELETETOPICS_RESULT) break;
+        auto result = checkTopicsReady(topics, std::max(remaining, std::chrono::milliseconds(0)));
+        if (!result.error) return result;
 
-        if (rk_ev)
+        KAFKA_API_DO_LOG(LOG_DEBUG, "topics[%s] not ready yet: %s", toString(topics).c_str(), result.detail.c_str());
+
+        if (std::chrono::steady_clock::now() + backoff >= end)
         {
-            KAFKA_API_DO_LOG(LOG_INFO, "rd_kafka_queue_poll got event[%s], with error[%s]", rd_kafka_event_name(rk_ev.get()), rd_kafka_event_error_string(rk_ev.get()));
-            rk_ev.reset();
+            return ErrorWithDetail(RD_KAFKA_RESP_ERR__TIMED_OUT, "Waiting for topics ready timed out, " + result.detail);
         }
-    } while (std::chrono::steady_clock::now() < end);
 
-    if (!rk_ev)
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min(backoff * 2, std::chrono::milliseconds(READINESS_MAX_BACKOFF_MS));
+    }
+}
+
+inline Admin::CreateTopicsPerTopicResult
+AdminClient::createTopics(const std::vector<Admin::NewTopicSpec>& specs, std::chrono::milliseconds timeout)
+{
+    const auto end = std::chrono::steady_clock::now() + timeout;
+
+    // The results collected from all the requests
+    struct Collector
     {
-        return Admin::DeleteTopicsResult(RD_KAFKA_RESP_ERR__TIMED_OUT, "No response within the time limit");
+        std::mutex                       lock;
+        std::map<Topic, ErrorWithDetail> results;
+        std::size_t                      pendingRequests = 0;
+        std::promise<void>               allDone;
+    };
+    auto collector = std::make_shared<Collector>();
+
+    Admin::CreateTopicsPerTopicResult ret;
+
+    // A topic specified more than once would fail the whole CreateTopics request (with the other topics in it), -- thus rejected locally
+    std::map<Topic, std::size_t> occurrences;
+    for (const auto& spec: specs) ++occurrences[spec.topic];
+
+    // Split the topics into requests, -- the ones rejected locally (i.e, with invalid partition count or replication factor, or duplicated) would not be sent
+    std::vector<std::pair<Topics, std::vector<rd_kafka_NewTopic_unique_ptr>>> requests;
+    for (const auto& spec: specs)
+    {
+        if (occurrences[spec.topic] > 1)
+        {
+            ret.topicResults.emplace(spec.topic, ErrorWithDetail(RD_KAFKA_RESP_ERR__INVALID_ARG, "Topic[" + spec.topic + "] specified more than once"));
+            continue;
+        }
+
+        std::string errMsg;
+        auto rkNewTopic = newTopic(spec, errMsg);
+        if (!rkNewTopic)
+        {
+            ret.topicResults.emplace(spec.topic, ErrorWithDetail(RD_KAFKA_RESP_ERR__INVALID_ARG, errMsg));
+            continue;
+        }
+
+        if (requests.empty() || requests.back().second.size() >= MAX_TOPICS_PER_REQUEST)
+        {
+            requests.emplace_back();
+        }
+        requests.back().first.emplace(spec.topic);
+        requests.back().second.emplace_back(std::move(rkNewTopic));
     }
 
-    std::list<ErrorWithDetail> errors;
+    collector->pendingRequests = requests.size();
+    auto allDone = collector->allDone.get_future();
+    if (requests.empty()) collector->allDone.set_value();
 
-    if (rd_kafka_resp_err_t respErr = rd_kafka_event_error(rk_ev.get()))
+    // Send all the requests at once, -- they would be served concurrently
+    for (auto& request: requests)
     {
-        errors.emplace_back(respErr, rd_kafka_event_error_string(rk_ev.get()));
+        const Topics& topics = request.first;
+
+        std::vector<rd_kafka_NewTopic_t*> rk_topics;
+        rk_topics.reserve(request.second.size());
+        for (const auto& topic : request.second) { rk_topics.emplace_back(topic.get()); }
+
+        auto rk_options = prepareOperation(RD_KAFKA_ADMIN_OP_CREATETOPICS, timeout,
+                                           [collector, topics](rd_kafka_event_t* rk_ev) {
+                                               auto results = getPerTopicCreateResults(rk_ev, topics);
+
+                                               std::lock_guard<std::mutex> lock(collector->lock);
+                                               collector->results.insert(results.begin(), results.end());
+                                               if (--collector->pendingRequests == 0) collector->allDone.set_value();
+                                           });
+
+        rd_kafka_CreateTopics(getClientHandle(), rk_topics.data(), rk_topics.size(), rk_options.get(), _rk_queue.get());
     }
 
-    // Fetch per-topic results
-    const rd_kafka_DeleteTopics_result_t* res = rd_kafka_event_DeleteTopics_result(rk_ev.get());
-    std::size_t res_topic_cnt{};
-    const rd_kafka_topic_result_t** res_topics = rd_kafka_DeleteTopics_result_topics(res, &res_topic_cnt);
+    allDone.wait_until(end);
 
-    errors.splice(errors.end(), getPerTopicResults(res_topics, res_topic_cnt));
+    Topics created;
+    {
+        std::lock_guard<std::mutex> lock(collector->lock);
+        for (const auto& result: collector->results)
+        {
+            if (!result.second.error) created.emplace(result.first);
+        }
+        ret.topicResults.insert(collector->results.begin(), collector->results.end());
+    }
 
-    return combineErrors(errors);
+    for (const auto& request: requests)
+    {
+        for (const auto& topic: request.first)
+        {
+            ret.topicResults.emplace(topic, ErrorWithDetail(RD_KAFKA_RESP_ERR__TIMED_OUT, "No response within the time limit"));
+        }
+    }
+
+    // Wait for the partition leaders of the created topics
+    if (!created.empty())
+    {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(end - std::chrono::steady_clock::now());
+        auto readyResult = waitForTopicsReady(created, std::max(remaining, std::chrono::milliseconds(0)));
+        if (readyResult.error)
+        {
+            static_cast<ErrorWithDetail&>(ret) = readyResult;
+        }
+    }
+
+    // The first failure (if any) for the whole batch
+    for (const auto& result: ret.topicResults)
+    {
+        if (result.second.error)
+        {
+            static_cast<ErrorWithDetail&>(ret) = result.second;
+            break;
+        }
+    }
+
+    return ret;
+}
+
+inline void
+AdminClient::createPartitionsAsync(const std::map<Topic, int>& newTotalCounts, std::chrono::milliseconds timeout, CreatePartitionsCallback cb)
+{
+    LogBuffer<500> errInfo;
+
+    std::vector<rd_kafka_NewPartitions_unique_ptr> rkNewPartitions;
+
+    for (const auto& newTotalCount: newTotalCounts)
+    {
+        const Topic& topic = newTotalCount.first;
+        if (newTotalCount.second <= 0)
+        {
+            cb(Admin::CreatePartitionsResult(RD_KAFKA_RESP_ERR__INVALID_ARG, "Invalid partition count[" + std::to_string(newTotalCount.second) + "] for topic[" + topic + "]"));
+            return;
+        }
+
+        rkNewPartitions.emplace_back(rd_kafka_NewPartitions_new(topic.c_str(), static_cast<std::size_t>(newTotalCount.second), errInfo.str(), errInfo.capacity()));
+        if (!rkNewPartitions.back())
+        {
+            cb(Admin::CreatePartitionsResult(RD_KAFKA_RESP_ERR__INVALID_ARG, "Invalid topic[" + topic + "], " + errInfo.c_str()));
+            return;
+        }
+    }
+
+    std::vector<rd_kafka_NewPartitions_t*> rk_partitions;
+    rk_partitions.reserve(rkNewPartitions.size());
+    for (const auto& partitions : rkNewPartitions) { rk_partitions.emplace_back(partitions.get()); }
+
+    auto rk_options = prepareOperation(RD_KAFKA_ADMIN_OP_CREATEPARTITIONS, timeout,
+                                       [cb](rd_kafka_event_t* rk_ev) { cb(getTopicsResult(rk_ev)); });
+
+    rd_kafka_CreatePartitions(getClientHandle(), rk_partitions.data(), rk_partitions.size(), rk_options.get(), _rk_queue.get());
+}
+
+inline std::future<Admin::CreatePartitionsResult>
+AdminClient::createPartitionsAsync(const std::map<Topic, int>& newTotalCounts, std::chrono::milliseconds timeout)
+{
+    auto promise = std::make_shared<std::promise<Admin::CreatePartitionsResult>>();
+    auto future  = promise->get_future();
+
+    createPartitionsAsync(newTotalCounts, timeout, [promise](const Admin::CreatePartitionsResult& result) { promise->set_value(result); });
+
+    return future;
+}
+
+inline Admin::CreatePartitionsResult
+AdminClient::createPartitions(const std::map<Topic, int>& newTotalCounts, std::chrono::milliseconds timeout)
+{
+    auto future = createPartitionsAsync(newTotalCounts, timeout);
+    if (future.wait_for(timeout) != std::future_status::ready)
+    {
+        return Admin::CreatePartitionsResult(RD_KAFKA_RESP_ERR__TIMED_OUT, "No response within the time limit");
+    }
+
+    auto result = future.get();
+
+    // The cached metadata (if any) is out of date
+    for (const auto& newTotalCount: newTotalCounts)
+    {
+        invalidateBrokerMetadata(newTotalCount.first);
+    }
+
+    return result;
+}
+
+inline Admin::CreatePartitionsResult
+AdminClient::createPartitions(const std::map<Topic, int>& newTotalCounts,
+                              const std::vector<std::reference_wrapper<KafkaClient>>& clientsToRefresh,
+                              std::chrono::milliseconds timeout)
+{
+    const auto end = std::chrono::steady_clock::now() + timeout;
+
+    auto result = createPartitions(newTotalCounts, timeout);
+    if (result.error || clientsToRefresh.empty()) return result;
+
+    Topics topics;
+    for (const auto& newTotalCount: newTotalCounts) topics.emplace(newTotalCount.first);
+
+    // Otherwise, the clients might see the new partitions without leaders
+    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(end - std::chrono::steady_clock::now());
+    auto readyResult = waitForTopicsReady(topics, std::max(remaining, std::chrono::milliseconds(0)));
+    if (readyResult.error) return readyResult;
+
+    // The metadata (from the brokers) might not reflect the new partitions at once, -- thus retry until every client sees them
+    for (auto& client: clientsToRefresh)
+    {
+        auto backoff = std::chrono::milliseconds(READINESS_MIN_BACKOFF_MS);
+        for (;;)
+        {
+            const auto timeLeft = std::chrono::duration_cast<std::chrono::milliseconds>(end - std::chrono::steady_clock::now());
+            const auto metadatas = client.get().refreshBrokerMetadata(topics, std::max(timeLeft, std::chrono::milliseconds(0)));
+
+            Topics notRefreshed;
+            for (const auto& newTotalCount: newTotalCounts)
+            {
+                auto it = metadatas.find(newTotalCount.first);
+                if (it == metadatas.end() || it->second.partitions().size() < static_cast<std::size_t>(newTotalCount.second))
+                {
+                    notRefreshed.emplace(newTotalCount.first);
+                }
+            }
+            if (notRefreshed.empty()) break;
+
+            if (std::chrono::steady_clock::now() + backoff >= end)
+            {
+                return Admin::CreatePartitionsResult(RD_KAFKA_RESP_ERR__TIMED_OUT,
+                                                     "Client[" + client.get().name() + "] failed to refresh metadata for topics[" + toString(notRefreshed) + "] within the time limit");
+            }
+
+            std::this_thread::sleep_for(backoff);
+            backoff = std::min(backoff * 2, std::chrono::milliseconds(READINESS_MAX_BACKOFF_MS));
+        }
+    }
+
+    return result;
+}
+
+inline Admin::DeleteTopicsResult
+AdminClient::deleteTopics(const Topics& topics, std::chrono::milliseconds timeout)
+{
+    auto future = deleteTopicsAsync(topics, timeout);
+    if (future.wait_for(timeout) != std::future_status::ready)
+    {
+        return Admin::DeleteTopicsResult(RD_KAFKA_RESP_ERR__TIMED_OUT, "No response within the time limit");
+    }
+
+    return future.get();
 }
 
 inline Admin::ListTopicsResult
 AdminClient::listTopics(std::chrono::milliseconds timeout)
 {
-    const rd_kafka_metadata_t* rk_metadata = nullptr;
-    rd_kafka_resp_err_t err = rd_kafka_metadata(getClientHandle(), true, nullptr, &rk_metadata, convertMsDurationToInt(timeout));
-    auto guard = rd_kafka_metadata_unique_ptr(rk_metadata);
+    return listTopicsWithMetadata(nullptr, timeout);
+}
 
-    if (err != RD_KAFKA_RESP_ERR_NO_ERROR)
+inline Admin::ListTopicsResult
+AdminClient::listTopics(const Topics& topics, std::chrono::milliseconds timeout)
+{
+    return listTopicsWithMetadata(&topics, timeout);
+}
+
+inline Admin::ListTopicsResult
+AdminClient::listTopicsWithMetadata(const Topics* topics, std::chrono::milliseconds timeout)
+{
+    const TopicsMetadata topicsMetadata = fetchTopicsMetadata(topics, timeout);
+    if (topicsMetadata.error != RD_KAFKA_RESP_ERR_NO_ERROR)
     {
-        return Admin::ListTopicsResult(err, rd_kafka_err2str(err));
+        return Admin::ListTopicsResult(topicsMetadata.error, rd_kafka_err2str(topicsMetadata.error));
     }
 
-    Topics names;
-    for (int i = 0; i < rk_metadata->topic_cnt; ++i)
+    Topics               names;
+    std::map<Topic, int> numPartitions;
+    for (const auto* metadata_topic: topicsMetadata.topics)
     {
-        names.insert(rk_metadata->topics[i].topic);
+        // Skip the specified topics not existing (e.g, UNKNOWN_TOPIC_OR_PART)
+        if (topics && metadata_topic->err != RD_KAFKA_RESP_ERR_NO_ERROR) continue;
+
+        names.insert(metadata_topic->topic);
+        numPartitions.emplace(metadata_topic->topic, metadata_topic->partition_cnt);
     }
-    return Admin::ListTopicsResult(names);
+    return Admin::ListTopicsResult(std::move(names), std::move(numPartitions));
 }
 
 } // end of KAFKA_API
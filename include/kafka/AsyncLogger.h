@@ -0,0 +1,296 @@
+#pragma once
+
+#include "kafka/Project.h"
+
+#include "kafka/Logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <syslog.h>
+#include <thread>
+#include <time.h>
+
+
+namespace KAFKA_API {
+
+/**
+ * An asynchronous logger, -- it could be used as the `Logger` for `KafkaClient::setLogger()`/`KafkaClient::setGlobalLogger()`.
+ *  - The logging threads (e.g, librdkafka's internal broker threads) only format the line (with a cached timestamp prefix) into a bounded lock-free MPSC ring.
+ *  - A background thread drains the ring, and writes the lines (in batches) with the `Sink`.
+ *  - A line would be dropped (and counted) if the ring is full, -- the logging threads never block. The number of dropped lines would be reported with the next batch.
+ * Note: The copies share the same ring and background thread, which would be stopped (after the ring is drained) once the last copy is destroyed.
+ *
+ * E.g,
+ *     Kafka::AsyncLogger asyncLogger;
+ *     Kafka::KafkaClient::setGlobalLogger(asyncLogger);
+ */
+class AsyncLogger
+{
+public:
+    /**
+     * Writes a batch of formatted lines (each line ends with '\n').
+     */
+    using Sink = std::function<void(const char* lines, std::size_t len)>;
+
+    /**
+     * Writes to stdout, -- with one flush per batch.
+     */
+    static void StdoutSink(const char* lines, std::size_t len)
+    {
+        std::fwrite(lines, 1, len, stdout);
+        std::fflush(stdout);
+    }
+
+#if __cplusplus >= 201703L
+    static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+#else
+    enum { DEFAULT_CAPACITY = 1024 };
+#endif
+
+    /**
+     * The `capacity` (number of lines the ring could hold) would be rounded up to a power of 2.
+     */
+    explicit AsyncLogger(std::size_t capacity = DEFAULT_CAPACITY, Sink sink = StdoutSink)
+        : _state(std::make_shared<State>(capacity, std::move(sink)))
+    {
+    }
+
+    /**
+     * The `Logger` interface, -- it's thread-safe, and never blocks.
+     */
+    void operator()(int level, const char* /*filename*/, int /*lineno*/, const char* msg) const { _state->push(level, msg); }
+
+    /**
+     * Number of lines dropped (since the ring was full).
+     */
+    std::uint64_t dropped() const { return _state->dropped.load(std::memory_order_relaxed); }
+
+private:
+    // ENTRY_SIZE: Max length for a formatted line (the longer ones would be truncated)
+    // BATCH_SIZE: The lines would be written once the batch reaches such a size (or the ring is drained)
+#if __cplusplus >= 201703L
+    static constexpr std::size_t ENTRY_SIZE     = 1024;
+    static constexpr std::size_t BATCH_SIZE     = 64 * 1024;
+    static constexpr int         IDLE_WAIT_MS   = 100;
+#else
+    enum { ENTRY_SIZE = 1024, BATCH_SIZE = 64 * 1024, IDLE_WAIT_MS = 100 };
+#endif
+
+    // A slot of the ring, -- the sequence tells whether it's ready for the producers (== pos), or for the consumer (== pos + 1)
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence = {0};
+        std::size_t              len      = 0;
+        char                     data[ENTRY_SIZE];
+    };
+
+    struct State
+    {
+        State(std::size_t capacity, Sink s);
+        ~State();
+
+        void push(int level, const char* msg);
+        bool pop(std::string& batch);
+        void keepWriting();
+
+        const std::size_t        mask;
+        std::unique_ptr<Cell[]>  cells;
+        std::atomic<std::size_t> enqueuePos = {0};
+        std::size_t              dequeuePos = 0;     // Only accessed by the background thread
+
+        std::atomic<std::uint64_t> dropped  = {0};
+        std::uint64_t              reported = 0;     // Only accessed by the background thread
+
+        const Sink               sink;
+
+        std::atomic<bool>        idle    = {false};
+        std::atomic<bool>        running = {true};
+        std::mutex               lock;
+        std::condition_variable  cv;
+        std::thread              writer;
+    };
+
+    // Format the timestamp prefix, e.g, "[2021-03-01 12:00:00.", -- it's cached (per thread) until the second changes
+    static const char* timestampPrefix(std::time_t seconds);
+
+    static std::size_t formatLine(char* buf, std::size_t size, int level, const char* msg);
+
+    static std::size_t roundUpToPowerOf2(std::size_t n)
+    {
+        std::size_t ret = 1;
+        while (ret < n) ret <<= 1;
+        return ret;
+    }
+
+    std::shared_ptr<State> _state;
+};
+
+inline const char*
+AsyncLogger::timestampPrefix(std::time_t seconds)
+{
+    thread_local std::time_t cachedSeconds = -1;
+    thread_local char        cachedPrefix[32] = {0};
+
+    if (seconds != cachedSeconds)
+    {
+        std::tm tmBuf = {};
+        if (std::strftime(cachedPrefix, sizeof(cachedPrefix), "[%F %T.", localtime_r(&seconds, &tmBuf)) == 0) cachedPrefix[0] = 0;
+        cachedSeconds = seconds;
+    }
+    return cachedPrefix;
+}
+
+inline std::size_t
+AsyncLogger::formatLine(char* buf, std::size_t size, int level, const char* msg)
+{
+    using namespace std::chrono;
+    const auto current = system_clock::now().time_since_epoch();
+    const auto seconds = duration_cast<std::chrono::seconds>(current);
+    const auto micros  = duration_cast<microseconds>(current - seconds);
+
+    // Same format as the `DefaultLogger`
+    const int cnt = std::snprintf(buf, size, "%s%06d]%s %s\n",
+                                  timestampPrefix(static_cast<std::time_t>(seconds.count())), static_cast<int>(micros.count()), getLogLevelName(level), msg);
+    if (cnt < 0) return 0;
+
+    // Truncated, -- but still ends with '\n'
+    if (static_cast<std::size_t>(cnt) >= size)
+    {
+        buf[size - 2] = '\n';
+        return size - 1;
+    }
+    return static_cast<std::size_t>(cnt);
+}
+
+inline
+AsyncLogger::State::State(std::size_t capacity, Sink s)
+    : mask(roundUpToPowerOf2(std::max<std::size_t>(capacity, 2)) - 1),
+      cells(new Cell[mask + 1]),
+      sink(std::move(s))
+{
+    for (std::size_t i = 0; i <= mask; ++i)
+    {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    writer = std::thread(&State::keepWriting, this);
+}
+
+inline
+AsyncLogger::State::~State()
+{
+    running = false;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        idle = false;
+    }
+    cv.notify_one();
+
+    if (writer.joinable()) writer.join();
+}
+
+inline void
+AsyncLogger::State::push(int level, const char* msg)
+{
+    std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    for (;;)
+    {
+        cell = &cells[pos & mask];
+        const std::size_t seq  = cell->sequence.load(std::memory_order_acquire);
+        const auto        diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+        if (diff == 0)
+        {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        }
+        else if (diff < 0)
+        {
+            // The ring is full
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->len = formatLine(cell->data, ENTRY_SIZE, level, msg);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    // Only wake up the writer while it's waiting, -- otherwise, it would drain the ring anyway
+    if (idle.load(std::memory_order_relaxed) && idle.exchange(false))
+    {
+        cv.notify_one();
+    }
+}
+
+inline bool
+AsyncLogger::State::pop(std::string& batch)
+{
+    Cell& cell = cells[dequeuePos & mask];
+    if (cell.sequence.load(std::memory_order_acquire) != dequeuePos + 1) return false;
+
+    batch.append(cell.data, cell.len);
+    cell.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+    ++dequeuePos;
+    return true;
+}
+
+inline void
+AsyncLogger::State::keepWriting()
+{
+    std::string batch;
+    batch.reserve(BATCH_SIZE + ENTRY_SIZE);
+
+    for (;;)
+    {
+        // Anything pushed before the stop would still be written
+        const bool stopping = !running.load();
+
+        while (pop(batch))
+        {
+            if (batch.size() >= BATCH_SIZE)
+            {
+                sink(batch.data(), batch.size());
+                batch.clear();
+            }
+        }
+
+        const std::uint64_t droppedNow = dropped.load(std::memory_order_relaxed);
+        if (droppedNow != reported)
+        {
+            char buf[128];
+            const std::string msg = std::to_string(droppedNow - reported) + " log lines dropped (the ring is full)";
+            batch.append(buf, formatLine(buf, sizeof(buf), LOG_WARNING, msg.c_str()));
+            reported = droppedNow;
+        }
+
+        if (!batch.empty())
+        {
+            sink(batch.data(), batch.size());
+            batch.clear();
+        }
+
+        if (stopping) return;
+
+        // A wake-up might be missed (e.g, a line was pushed right before `idle` was set), -- thus the wait is bounded
+        std::unique_lock<std::mutex> guard(lock);
+        idle = true;
+        cv.wait_for(guard, std::chrono::milliseconds(IDLE_WAIT_MS), [this]() { return !idle.load(); });
+        idle = false;
+    }
+}
+
+} // end of KAFKA_API
+
@@ -7,7 +7,14 @@
 
 #include "librdkafka/rdkafka.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
 
@@ -76,6 +83,33 @@ struct BrokerMetadata {
 
     };
 
+    /**
+     * A contiguous range of node ids (e.g, the replicas of a partition), -- within a buffer shared by all partitions.
+     */
+    class NodeIds
+    {
+    public:
+        NodeIds(const Node::Id* first, const Node::Id* last): _begin(first), _end(last) {}
+
+        const Node::Id* begin() const { return _begin; }
+        const Node::Id* end()   const { return _end; }
+        std::size_t     size()  const { return static_cast<std::size_t>(_end - _begin); }
+        bool            empty() const { return _begin == _end; }
+
+    private:
+        const Node::Id* _begin;
+        const Node::Id* _end;
+    };
+
+    /**
+     * The node id for "no leader".
+     */
+#if __cplusplus >= 201703L
+    static constexpr Node::Id NO_LEADER = -1;
+#else
+    enum { NO_LEADER = -1 };
+#endif
+
     /**
      * Obtains explanatory string from Node::Id.
      */
@@ -98,13 +132,56 @@ struct BrokerMetadata {
 
     /**
      * The nodes info in the MetadataResponse.
+     * Note: The `Node`s are constructed (from the node table) at the first call, and shared by the following calls, -- until the nodes are changed with `addNode()`.
      */
     std::vector<std::shared_ptr<Node>> nodes() const;
 
+    /**
+     * The nodes info in the MetadataResponse (ordered by node id).
+     */
+    const std::vector<Node>& nodeTable() const { return _nodes; }
+
+    /**
+     * The node with the id (or nullptr, if it's not in the MetadataResponse).
+     */
+    const Node* node(Node::Id id) const;
+
     /**
      * The partitions' state in the MetadataResponse.
+     * Note: The map is constructed (from the flat layout) at the first call, and cached, -- the reference keeps valid until the partitions are changed (e.g, with `addPartition()`).
+     *       Prefer `leaderFor()`/`replicasFor()`/`inSyncReplicasFor()` for lookups.
      */
-    const std::map<Partition, PartitionInfo>& partitions() const { return _partitions; }
+    const std::map<Partition, PartitionInfo>& partitions() const;
+
+    /**
+     * Number of partitions with valid state in the MetadataResponse.
+     */
+    std::size_t numPartitions() const { return _numPartitions; }
+
+    /**
+     * Whether the partition has valid state in the MetadataResponse.
+     */
+    bool hasPartition(Partition partition) const { return partition >= 0 && static_cast<std::size_t>(partition) < _present.size() && _present[static_cast<std::size_t>(partition)]; }
+
+    /**
+     * The leader for the partition (or NO_LEADER, if it's unknown). O(1).
+     */
+    Node::Id leaderFor(Partition partition) const { return hasPartition(partition) ? _leaders[static_cast<std::size_t>(partition)] : static_cast<Node::Id>(NO_LEADER); }
+
+    /**
+     * The replicas for the partition. O(1).
+     */
+    NodeIds replicasFor(Partition partition) const { return nodeIds(_replicaSpans, partition); }
+
+    /**
+     * The in-sync replicas for the partition. O(1).
+     */
+    NodeIds inSyncReplicasFor(Partition partition) const { return nodeIds(_isrSpans, partition); }
+
+    /**
+     * The partitions (in ascending order) led by the node, -- for leader-aware routing.
+     */
+    const std::vector<Partition>& partitionsLedBy(Node::Id id) const;
 
     /**
      * Obtains explanatory string.
@@ -112,43 +189,218 @@ struct BrokerMetadata {
     std::string toString()   const;
 
     void setOrigNodeName(const std::string& origNodeName)                          { _origNodeName = origNodeName; }
-    void addNode(Node::Id nodeId, const Node::Host& host, Node::Port port)         { _nodes[nodeId] = std::make_shared<Node>(nodeId, host, port); }
-    void addPartitionInfo(Partition partition, const PartitionInfo& partitionInfo) { _partitions.emplace(partition, partitionInfo); }
+    void addNode(Node::Id nodeId, const Node::Host& host, Node::Port port);
+    void addPartitionInfo(Partition partition, const PartitionInfo& partitionInfo)
+    {
+        addPartition(partition, partitionInfo.leader,
+                     partitionInfo.replicas.data(),       static_cast<int>(partitionInfo.replicas.size()),
+                     partitionInfo.inSyncReplicas.data(), static_cast<int>(partitionInfo.inSyncReplicas.size()));
+    }
+    void addPartition(Partition partition, Node::Id leader, const Node::Id* replicas, int replicaCount, const Node::Id* isrs, int isrCount);
 
 private:
-    Topic                                     _topic;
-    std::string                               _origNodeName;
-    std::map<Node::Id, std::shared_ptr<Node>> _nodes;
-    std::map<Partition, PartitionInfo>        _partitions;
+    // A range within `_nodeIdBuffer`
+    struct Span
+    {
+        std::uint32_t offset = 0;
+        std::uint32_t count  = 0;
+    };
+
+    NodeIds nodeIds(const std::vector<Span>& spans, Partition partition) const
+    {
+        if (!hasPartition(partition)) return NodeIds(nullptr, nullptr);
+
+        const Span& span = spans[static_cast<std::size_t>(partition)];
+        return NodeIds(_nodeIdBuffer.data() + span.offset, _nodeIdBuffer.data() + span.offset + span.count);
+    }
+
+    Span appendNodeIds(const Node::Id* ids, int count)
+    {
+        Span span;
+        span.offset = static_cast<std::uint32_t>(_nodeIdBuffer.size());
+        span.count  = static_cast<std::uint32_t>(count > 0 ? count : 0);
+        _nodeIdBuffer.insert(_nodeIdBuffer.end(), ids, ids + span.count);
+        return span;
+    }
+
+    std::string toString(Node::Id leader, NodeIds replicas, NodeIds inSyncReplicas) const;
+
+    // A view constructed on demand (at most once, even with concurrent calls), -- it's shared by the copies, and dropped with `reset()` while the metadata changes
+    template <typename T>
+    class LazyView
+    {
+    public:
+        LazyView() = default;
+        LazyView(const LazyView& other): _view(std::atomic_load(&other._view)) {}
+        LazyView& operator=(const LazyView& other)
+        {
+            std::atomic_store(&_view, std::atomic_load(&other._view));
+            return *this;
+        }
+
+        template <typename Builder>
+        const T& get(Builder build) const
+        {
+            std::shared_ptr<const T> view = std::atomic_load(&_view);
+            if (!view)
+            {
+                auto built = std::make_shared<const T>(build());
+                // If some other thread has done it first, just use that one
+                view = std::atomic_compare_exchange_strong(&_view, &view, built) ? built : view;
+            }
+            return *view;
+        }
+
+        void reset() { std::atomic_store(&_view, std::shared_ptr<const T>()); }
+
+    private:
+        mutable std::shared_ptr<const T> _view;
+    };
+
+    Topic                 _topic;
+    std::string           _origNodeName;
+
+    // Node table, ordered by id
+    std::vector<Node>     _nodes;
+
+    // Indexed by partition
+    std::vector<bool>     _present;
+    std::vector<Node::Id> _leaders;
+    std::vector<Span>     _replicaSpans;
+    std::vector<Span>     _isrSpans;
+    std::size_t           _numPartitions = 0;
+
+    // Replicas and in-sync replicas for all partitions
+    std::vector<Node::Id> _nodeIdBuffer;
+
+    // Partitions grouped by leader, ordered by leader id
+    std::vector<std::pair<Node::Id, std::vector<Partition>>> _partitionsByLeader;
+
+    // For the map-based accessors
+    LazyView<std::vector<std::shared_ptr<Node>>> _nodesView;
+    LazyView<std::map<Partition, PartitionInfo>> _partitionsView;
 };
 
 inline std::vector<std::shared_ptr<BrokerMetadata::Node>>
 BrokerMetadata::nodes() const
 {
-    std::vector<std::shared_ptr<BrokerMetadata::Node>> ret;
-    for (const auto& nodeInfo: _nodes)
+    return _nodesView.get([this]() {
+        std::vector<std::shared_ptr<BrokerMetadata::Node>> ret;
+        ret.reserve(_nodes.size());
+        for (const auto& nodeInfo: _nodes)
+        {
+            ret.emplace_back(std::make_shared<Node>(nodeInfo));
+        }
+        return ret;
+    });
+}
+
+inline const BrokerMetadata::Node*
+BrokerMetadata::node(Node::Id id) const
+{
+    auto it = std::lower_bound(_nodes.cbegin(), _nodes.cend(), id, [](const Node& n, Node::Id nodeId) { return n.id < nodeId; });
+    return (it != _nodes.cend() && it->id == id) ? &(*it) : nullptr;
+}
+
+inline void
+BrokerMetadata::addNode(Node::Id nodeId, const Node::Host& host, Node::Port port)
+{
+    _nodesView.reset();
+
+    auto it = std::lower_bound(_nodes.begin(), _nodes.end(), nodeId, [](const Node& n, Node::Id id) { return n.id < id; });
+    if (it != _nodes.end() && it->id == nodeId)
+    {
+        *it = Node(nodeId, host, port);
+    }
+    else
+    {
+        _nodes.emplace(it, nodeId, host, port);
+    }
+}
+
+inline void
+BrokerMetadata::addPartition(Partition partition, Node::Id leader, const Node::Id* replicas, int replicaCount, const Node::Id* isrs, int isrCount)
+{
+    if (partition < 0 || hasPartition(partition)) return;
+
+    _partitionsView.reset();
+
+    const auto index = static_cast<std::size_t>(partition);
+    if (index >= _present.size())
     {
-        ret.emplace_back(nodeInfo.second);
+        _present.resize(index + 1, false);
+        _leaders.resize(index + 1, static_cast<Node::Id>(NO_LEADER));
+        _replicaSpans.resize(index + 1);
+        _isrSpans.resize(index + 1);
     }
-    return ret;
+
+    _present[index]      = true;
+    _leaders[index]      = leader;
+    _replicaSpans[index] = appendNodeIds(replicas, replicaCount);
+    _isrSpans[index]     = appendNodeIds(isrs, isrCount);
+    ++_numPartitions;
+
+    if (leader == NO_LEADER) return;
+
+    auto it = std::lower_bound(_partitionsByLeader.begin(), _partitionsByLeader.end(), leader,
+                               [](const std::pair<Node::Id, std::vector<Partition>>& entry, Node::Id id) { return entry.first < id; });
+    if (it == _partitionsByLeader.end() || it->first != leader)
+    {
+        it = _partitionsByLeader.emplace(it, leader, std::vector<Partition>());
+    }
+
+    // The partitions are mostly added in ascending order
+    std::vector<Partition>& led = it->second;
+    led.insert(std::upper_bound(led.begin(), led.end(), partition), partition);
+}
+
+inline const std::vector<Partition>&
+BrokerMetadata::partitionsLedBy(Node::Id id) const
+{
+    static const std::vector<Partition> none;
+
+    auto it = std::lower_bound(_partitionsByLeader.cbegin(), _partitionsByLeader.cend(), id,
+                               [](const std::pair<Node::Id, std::vector<Partition>>& entry, Node::Id nodeId) { return entry.first < nodeId; });
+    return (it != _partitionsByLeader.cend() && it->first == id) ? it->second : none;
+}
+
+inline const std::map<Partition, BrokerMetadata::PartitionInfo>&
+BrokerMetadata::partitions() const
+{
+    return _partitionsView.get([this]() {
+        std::map<Partition, PartitionInfo> ret;
+        for (std::size_t i = 0; i < _present.size(); ++i)
+        {
+            if (!_present[i]) continue;
+
+            const auto partition = static_cast<Partition>(i);
+
+            PartitionInfo partitionInfo;
+            partitionInfo.setLeader(_leaders[i]);
+            for (auto id: replicasFor(partition))       partitionInfo.addReplica(id);
+            for (auto id: inSyncReplicasFor(partition)) partitionInfo.addInSyncReplica(id);
+
+            ret.emplace(partition, std::move(partitionInfo));
+        }
+        return ret;
+    });
 }
 
 inline std::string
 BrokerMetadata::getNodeDescription(Node::Id id) const
 {
-    const auto& found = _nodes.find(id);
-    if (found == _nodes.cend()) return "-:-/" + std::to_string(id);
+    const Node* found = node(id);
+    if (!found) return "-:-/" + std::to_string(id);
 
-    auto node = found->second;
-    return node->host + ":" + std::to_string(node->port) + "/" + std::to_string(id);
+    return found->host + ":" + std::to_string(found->port) + "/" + std::to_string(id);
 }
 
 inline std::string
-BrokerMetadata::toString(const PartitionInfo& partitionInfo) const
+BrokerMetadata::toString(Node::Id leader, NodeIds replicas, NodeIds inSyncReplicas) const
 {
     std::ostringstream oss;
 
-    auto streamNodes = [this](std::ostringstream& ss, const std::vector<Node::Id> nodeIds) -> std::ostringstream& {
+    auto streamNodes = [this](std::ostringstream& ss, NodeIds nodeIds) -> std::ostringstream& {
         bool isTheFirst = true;
         for (const auto id: nodeIds)
         {
@@ -157,13 +409,21 @@ BrokerMetadata::toString(const PartitionInfo& partitionInfo) const
         return ss;
     };
 
-    oss << "leader[" << getNodeDescription(partitionInfo.leader) << "], replicas[";
-    streamNodes(oss, partitionInfo.replicas) << "], inSyncReplicas[";
-    streamNodes(oss, partitionInfo.inSyncReplicas) << "]";
+    oss << "leader[" << getNodeDescription(leader) << "], replicas[";
+    streamNodes(oss, replicas) << "], inSyncReplicas[";
+    streamNodes(oss, inSyncReplicas) << "]";
 
     return oss.str();
 }
 
+inline std::string
+BrokerMetadata::toString(const PartitionInfo& partitionInfo) const
+{
+    return toString(partitionInfo.leader,
+                     NodeIds(partitionInfo.replicas.data(),       partitionInfo.replicas.data() + partitionInfo.replicas.size()),
+                     NodeIds(partitionInfo.inSyncReplicas.data(), partitionInfo.inSyncReplicas.data() + partitionInfo.inSyncReplicas.size()));
+}
+
 inline std::string
 BrokerMetadata::toString() const
 {
@@ -171,11 +431,12 @@ BrokerMetadata::toString() const
 
     oss << "originatingNode[" << _origNodeName << "], topic[" << _topic <<  "], partitions{";
     bool isTheFirst = true;
-    for (const auto& partitionInfoPair: _partitions)
+    for (std::size_t i = 0; i < _present.size(); ++i)
     {
-        const Partition       partition     = partitionInfoPair.first;
-        const PartitionInfo&  partitionInfo = partitionInfoPair.second;
-        oss << (isTheFirst ? (isTheFirst = false, "") : "; ") << partition << ": " << toString(partitionInfo);
+        if (!_present[i]) continue;
+
+        const auto partition = static_cast<Partition>(i);
+        oss << (isTheFirst ? (isTheFirst = false, "") : "; ") << partition << ": " << toString(_leaders[i], replicasFor(partition), inSyncReplicasFor(partition));
     }
     oss << "}";
 
@@ -0,0 +1,633 @@
+#pragma once
+
+#include "kafka/Project.h"
+
+#include "kafka/Types.h"
+
+#include "librdkafka/rdkafka.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace KAFKA_API {
+
+/**
+ * The typed statistics for a kafka client, -- filled with the JSON emitted by librdkafka (while the "statistics.interval.ms" property is configured with a non-0 value).
+ * Only the most commonly used metrics are picked up, see https://github.com/edenhill/librdkafka/blob/master/STATISTICS.md for the details.
+ * Note: 1) `parse()` is done with a single pass over the JSON (without constructing any DOM), and the unknown fields are skipped.
+ *       2) The memory (e.g, strings, vectors) of the previous result would be reused by `parse()`, -- thus keep an instance for the periodic parsing.
+ */
+struct ClientStatistics
+{
+    using Value = std::int64_t;
+
+    /**
+     * Rolling window statistics, -- e.g, for the round-trip time.
+     */
+    struct Window
+    {
+        Value min = 0;
+        Value max = 0;
+        Value avg = 0;
+        Value sum = 0;
+        Value cnt = 0;
+        Value p50 = 0;
+        Value p95 = 0;
+        Value p99 = 0;
+    };
+
+    /**
+     * Per-broker statistics.
+     */
+    struct BrokerStats
+    {
+        std::string  name;                  // e.g, "localhost:9092/1"
+        std::int32_t nodeId      = -1;
+        std::string  state;                 // e.g, "UP", "DOWN"
+        Value        outbufCnt   = 0;       // Requests awaiting transmission
+        Value        waitrespCnt = 0;       // Requests in-flight, awaiting response
+        Value        tx          = 0;
+        Value        txerrs      = 0;
+        Value        txretries   = 0;
+        Value        reqTimeouts = 0;
+        Value        rx          = 0;
+        Value        rxerrs      = 0;
+        Window       rtt;                   // Round-trip time (microseconds)
+        Window       throttle;              // Throttling time (milliseconds)
+        Window       intLatency;            // Internal producer queue latency (microseconds)
+
+        void reset()
+        {
+            std::string n = std::move(name), s = std::move(state);
+            *this = BrokerStats();
+            name  = std::move(n);
+            state = std::move(s);
+        }
+    };
+
+    /**
+     * Per-partition statistics.
+     */
+    struct PartitionStats
+    {
+        Partition    partition       = -1;
+        std::int32_t leader          = -1;
+        Value        msgqCnt         = 0;   // Messages in the first level queue
+        Value        msgqBytes       = 0;
+        Value        xmitMsgqCnt     = 0;   // Messages ready to be sent
+        Value        xmitMsgqBytes   = 0;
+        Value        fetchqCnt       = 0;   // Pre-fetched messages in the fetch queue
+        Value        fetchqSize      = 0;
+        Value        committedOffset = RD_KAFKA_OFFSET_INVALID;
+        Value        loOffset        = RD_KAFKA_OFFSET_INVALID;
+        Value        hiOffset        = RD_KAFKA_OFFSET_INVALID;
+        Value        lsOffset        = RD_KAFKA_OFFSET_INVALID;
+        Value        consumerLag     = -1;  // -1 if unknown
+        Value        txmsgs          = 0;
+        Value        txbytes         = 0;
+        Value        rxmsgs          = 0;
+        Value        rxbytes         = 0;
+        Value        msgsInflight    = 0;
+    };
+
+    /**
+     * Per-topic statistics.
+     */
+    struct TopicStats
+    {
+        Topic                       topic;
+        std::vector<PartitionStats> partitions; // The internal unassigned partition (-1) is excluded
+
+        void reset()
+        {
+            topic.clear();
+            partitions.clear();     // The capacity is kept
+        }
+    };
+
+    /**
+     * Consumer group statistics (only for consumers with "group.id" configured).
+     */
+    struct ConsumerGroupStats
+    {
+        std::string state;
+        std::string joinState;
+        Value       rebalanceCnt   = 0;
+        Value       assignmentSize = 0;
+
+        void reset()
+        {
+            state.clear();
+            joinState.clear();
+            rebalanceCnt   = 0;
+            assignmentSize = 0;
+        }
+    };
+
+    std::string        name;
+    std::string        clientId;
+    std::string        type;                // "producer" or "consumer"
+    Value              ts          = 0;     // Internal monotonic clock (microseconds)
+    Value              time        = 0;     // Wall clock time (seconds since epoch)
+    Value              replyq      = 0;     // Ops waiting in queue for the application to serve with poll
+    Value              msgCnt      = 0;     // Messages in producer queues
+    Value              msgSize     = 0;
+    Value              tx          = 0;
+    Value              txBytes     = 0;
+    Value              rx          = 0;
+    Value              rxBytes     = 0;
+    Value              txmsgs      = 0;
+    Value              txmsgBytes  = 0;
+    Value              rxmsgs      = 0;
+    Value              rxmsgBytes  = 0;
+    std::vector<BrokerStats> brokers;
+    std::vector<TopicStats>  topics;
+    ConsumerGroupStats       consumerGroup;
+
+    /**
+     * The sum of the known consumer lags for all partitions.
+     */
+    Value totalConsumerLag() const
+    {
+        Value total = 0;
+        for (const auto& topicStats: topics)
+        {
+            for (const auto& partitionStats: topicStats.partitions)
+            {
+                if (partitionStats.consumerLag > 0) total += partitionStats.consumerLag;
+            }
+        }
+        return total;
+    }
+
+    /**
+     * Fill with the statistics JSON. Returns false if the JSON is malformed (the content is unspecified then).
+     */
+    bool parse(const char* json, std::size_t len);
+    bool parse(const std::string& json) { return parse(json.data(), json.size()); }
+
+private:
+    class Reader;
+
+    // Reset the top-level fields (with the memory of the strings kept), -- thus the ones missing in the next JSON would not keep the previous values
+    void reset();
+
+    void parseBrokers(Reader& reader);
+    void parseTopics(Reader& reader);
+    static void parsePartitions(Reader& reader, std::vector<PartitionStats>& partitions);
+
+    // Reuse the element (if there's one) at the position, -- thus the memory it holds would be reused
+    template <typename T>
+    static T& nextElement(std::vector<T>& elements, std::size_t& count)
+    {
+        if (count == elements.size())
+        {
+            elements.emplace_back();
+        }
+        else
+        {
+            elements[count].reset();
+        }
+        return elements[count++];
+    }
+};
+
+
+/**
+ * A minimal pull-style JSON reader (for the statistics).
+ */
+class ClientStatistics::Reader
+{
+public:
+    Reader(const char* begin, const char* end): _cur(begin), _end(end) {}
+
+    /**
+     * A string token, -- pointing into the JSON (with the escapes not decoded).
+     */
+    struct Token
+    {
+        const char* data = nullptr;
+        std::size_t len  = 0;
+
+        template <std::size_t N>
+        bool is(const char (&s)[N]) const { return len == N - 1 && std::memcmp(data, s, N - 1) == 0; }
+    };
+
+    bool ok() const { return _ok; }
+
+    void fail() { _ok = false; _cur = _end; }
+
+    bool consume(char c)
+    {
+        skipWhitespaces();
+        if (_cur == _end || *_cur != c) return false;
+
+        ++_cur;
+        return true;
+    }
+
+    Token readToken();
+    void  readString(std::string& out);
+    Value readNumber();
+    void  skipValue();
+
+    /**
+     * Read an object, -- the value of each member must be consumed by `onMember(key)`.
+     */
+    template <typename OnMember>
+    void readObject(OnMember&& onMember)
+    {
+        if (!consume('{')) return fail();
+        if (consume('}')) return;
+
+        do
+        {
+            const Token key = readToken();
+            if (!_ok || !consume(':')) return fail();
+
+            onMember(key);
+            if (!_ok) return;
+        } while (consume(','));
+
+        if (!consume('}')) fail();
+    }
+
+    // Helpers to read the value into the field, -- if the key matches the name
+    template <std::size_t N>
+    bool field(const Token& key, const char (&name)[N], Value& value)
+    {
+        if (!key.is(name)) return false;
+
+        value = readNumber();
+        return true;
+    }
+
+    template <std::size_t N>
+    bool field(const Token& key, const char (&name)[N], std::int32_t& value)
+    {
+        if (!key.is(name)) return false;
+
+        value = static_cast<std::int32_t>(readNumber());
+        return true;
+    }
+
+    template <std::size_t N>
+    bool field(const Token& key, const char (&name)[N], std::string& value)
+    {
+        if (!key.is(name)) return false;
+
+        readString(value);
+        return true;
+    }
+
+    template <std::size_t N>
+    bool field(const Token& key, const char (&name)[N], Window& window)
+    {
+        if (!key.is(name)) return false;
+
+        readObject([this, &window](const Token& k) {
+            field(k, "min", window.min) || field(k, "max", window.max) || field(k, "avg", window.avg)
+                || field(k, "sum", window.sum) || field(k, "cnt", window.cnt)
+                || field(k, "p50", window.p50) || field(k, "p95", window.p95) || field(k, "p99", window.p99)
+                || skip();
+        });
+        return true;
+    }
+
+    bool skip() { skipValue(); return true; }
+
+private:
+    void skipWhitespaces()
+    {
+        while (_cur != _end && (*_cur == ' ' || *_cur == '\n' || *_cur == '\r' || *_cur == '\t')) ++_cur;
+    }
+
+    static int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    static void decodeEscapes(std::string& s);
+
+    const char* _cur;
+    const char* _end;
+    bool        _ok = true;
+};
+
+inline ClientStatistics::Reader::Token
+ClientStatistics::Reader::readToken()
+{
+    Token token;
+    if (!consume('"'))
+    {
+        fail();
+        return token;
+    }
+
+    token.data = _cur;
+    for (; _cur != _end && *_cur != '"'; ++_cur)
+    {
+        if (*_cur == '\\' && ++_cur == _end) break;
+    }
+
+    if (_cur == _end)
+    {
+        fail();
+        return Token();
+    }
+
+    token.len = static_cast<std::size_t>(_cur - token.data);
+    ++_cur;
+    return token;
+}
+
+inline void
+ClientStatistics::Reader::readString(std::string& out)
+{
+    const Token token = readToken();
+    out.assign(token.data ? token.data : "", token.len);
+
+    if (std::memchr(out.data(), '\\', out.size())) decodeEscapes(out);
+}
+
+inline void
+ClientStatistics::Reader::decodeEscapes(std::string& s)
+{
+    std::size_t to = 0;
+    for (std::size_t from = 0; from < s.size(); ++from)
+    {
+        char c = s[from];
+        if (c != '\\' || from + 1 == s.size())
+        {
+            s[to++] = c;
+            continue;
+        }
+
+        c = s[++from];
+        switch (c)
+        {
+            case 'b': s[to++] = '\b'; break;
+            case 'f': s[to++] = '\f'; break;
+            case 'n': s[to++] = '\n'; break;
+            case 'r': s[to++] = '\r'; break;
+            case 't': s[to++] = '\t'; break;
+            case 'u':
+            {
+                unsigned code = 0;
+                std::size_t i = 0;
+                for (; i < 4 && from + 1 < s.size() && hexValue(s[from + 1]) >= 0; ++i)
+                {
+                    code = (code << 4) | static_cast<unsigned>(hexValue(s[++from]));
+                }
+
+                // Encoded with UTF-8 (the surrogates are not combined), -- it never takes more space than the escape sequence
+                if (code < 0x80)
+                {
+                    s[to++] = static_cast<char>(code);
+                }
+                else if (code < 0x800)
+                {
+                    s[to++] = static_cast<char>(0xC0 | (code >> 6));
+                    s[to++] = static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    s[to++] = static_cast<char>(0xE0 | (code >> 12));
+                    s[to++] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    s[to++] = static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: s[to++] = c; break; // '"', '\\', '/'
+        }
+    }
+    s.resize(to);
+}
+
+inline ClientStatistics::Value
+ClientStatistics::Reader::readNumber()
+{
+    skipWhitespaces();
+
+    const bool negative = (_cur != _end && *_cur == '-');
+    if (negative) ++_cur;
+
+    if (_cur == _end || *_cur < '0' || *_cur > '9')
+    {
+        // Not a number (e.g, null), -- just skip it
+        if (negative)
+        {
+            fail();
+        }
+        else
+        {
+            skipValue();
+        }
+        return 0;
+    }
+
+    Value value = 0;
+    for (; _cur != _end && *_cur >= '0' && *_cur <= '9'; ++_cur)
+    {
+        value = value * 10 + (*_cur - '0');
+    }
+
+    // The fraction/exponent parts are truncated
+    while (_cur != _end && (*_cur == '.' || *_cur == 'e' || *_cur == 'E' || *_cur == '+' || *_cur == '-' || (*_cur >= '0' && *_cur <= '9'))) ++_cur;
+
+    return negative ? -value : value;
+}
+
+inline void
+ClientStatistics::Reader::skipValue()
+{
+    skipWhitespaces();
+    if (_cur == _end) return fail();
+
+    switch (*_cur)
+    {
+        case '"':
+            readToken();
+            break;
+        case '{':
+            readObject([this](const Token&) { skipValue(); });
+            break;
+        case '[':
+            ++_cur;
+            if (consume(']')) break;
+            do
+            {
+                skipValue();
+                if (!_ok) return;
+            } while (consume(','));
+            if (!consume(']')) fail();
+            break;
+        case '-':
+            readNumber();
+            break;
+        default:
+            if (*_cur >= '0' && *_cur <= '9')
+            {
+                readNumber();
+            }
+            else if (*_cur >= 'a' && *_cur <= 'z')
+            {
+                while (_cur != _end && *_cur >= 'a' && *_cur <= 'z') ++_cur; // true/false/null
+            }
+            else
+            {
+                fail();
+            }
+    }
+}
+
+
+inline void
+ClientStatistics::reset()
+{
+    name.clear();
+    clientId.clear();
+    type.clear();
+
+    ts = time = replyq = msgCnt = msgSize = 0;
+    tx = txBytes = rx = rxBytes = 0;
+    txmsgs = txmsgBytes = rxmsgs = rxmsgBytes = 0;
+
+    consumerGroup.reset();
+}
+
+inline bool
+ClientStatistics::parse(const char* json, std::size_t len)
+{
+    reset();
+
+    bool hasBrokers = false, hasTopics = false;
+
+    Reader reader(json, json + len);
+
+    reader.readObject([this, &reader, &hasBrokers, &hasTopics](const Reader::Token& key) {
+        if (key.is("brokers"))
+        {
+            parseBrokers(reader);
+            hasBrokers = true;
+        }
+        else if (key.is("topics"))
+        {
+            parseTopics(reader);
+            hasTopics = true;
+        }
+        else if (key.is("cgrp"))
+        {
+            ConsumerGroupStats& cg = consumerGroup;
+            reader.readObject([&reader, &cg](const Reader::Token& k) {
+                reader.field(k, "state", cg.state) || reader.field(k, "join_state", cg.joinState)
+                    || reader.field(k, "rebalance_cnt", cg.rebalanceCnt) || reader.field(k, "assignment_size", cg.assignmentSize)
+                    || reader.skip();
+            });
+        }
+        else
+        {
+            reader.field(key, "name", name) || reader.field(key, "client_id", clientId) || reader.field(key, "type", type)
+                || reader.field(key, "ts", ts) || reader.field(key, "time", time) || reader.field(key, "replyq", replyq)
+                || reader.field(key, "msg_cnt", msgCnt) || reader.field(key, "msg_size", msgSize)
+                || reader.field(key, "tx", tx) || reader.field(key, "tx_bytes", txBytes)
+                || reader.field(key, "rx", rx) || reader.field(key, "rx_bytes", rxBytes)
+                || reader.field(key, "txmsgs", txmsgs) || reader.field(key, "txmsg_bytes", txmsgBytes)
+                || reader.field(key, "rxmsgs", rxmsgs) || reader.field(key, "rxmsg_bytes", rxmsgBytes)
+                || reader.skip();
+        }
+    });
+
+    if (!hasBrokers) brokers.clear();
+    if (!hasTopics)  topics.clear();
+
+    return reader.ok();
+}
+
+inline void
+ClientStatistics::parseBrokers(Reader& reader)
+{
+    std::size_t count = 0;
+
+    reader.readObject([this, &reader, &count](const Reader::Token& /*brokerName*/) {
+        BrokerStats& broker = nextElement(brokers, count);
+        reader.readObject([&reader, &broker](const Reader::Token& k) {
+            reader.field(k, "name", broker.name) || reader.field(k, "nodeid", broker.nodeId) || reader.field(k, "state", broker.state)
+                || reader.field(k, "outbuf_cnt", broker.outbufCnt) || reader.field(k, "waitresp_cnt", broker.waitrespCnt)
+                || reader.field(k, "tx", broker.tx) || reader.field(k, "txerrs", broker.txerrs) || reader.field(k, "txretries", broker.txretries)
+                || reader.field(k, "req_timeouts", broker.reqTimeouts) || reader.field(k, "rx", broker.rx) || reader.field(k, "rxerrs", broker.rxerrs)
+                || reader.field(k, "rtt", broker.rtt) || reader.field(k, "throttle", broker.throttle) || reader.field(k, "int_latency", broker.intLatency)
+                || reader.skip();
+        });
+    });
+
+    brokers.resize(count);
+}
+
+inline void
+ClientStatistics::parseTopics(Reader& reader)
+{
+    std::size_t count = 0;
+
+    reader.readObject([this, &reader, &count](const Reader::Token& /*topicName*/) {
+        TopicStats& topicStats = nextElement(topics, count);
+        reader.readObject([&reader, &topicStats](const Reader::Token& k) {
+            if (k.is("partitions"))
+            {
+                parsePartitions(reader, topicStats.partitions);
+            }
+            else
+            {
+                reader.field(k, "topic", topicStats.topic) || reader.skip();
+            }
+        });
+    });
+
+    topics.resize(count);
+}
+
+inline void
+ClientStatistics::parsePartitions(Reader& reader, std::vector<PartitionStats>& partitions)
+{
+    std::size_t count = 0;
+
+    reader.readObject([&reader, &partitions, &count](const Reader::Token& partitionId) {
+        // The internal unassigned partition
+        if (partitionId.is("-1"))
+        {
+            reader.skipValue();
+            return;
+        }
+
+        if (count == partitions.size()) partitions.emplace_back();
+        PartitionStats& stats = partitions[count++];
+        stats = PartitionStats();
+
+        reader.readObject([&reader, &stats](const Reader::Token& k) {
+            reader.field(k, "partition", stats.partition) || reader.field(k, "leader", stats.leader)
+                || reader.field(k, "msgq_cnt", stats.msgqCnt) || reader.field(k, "msgq_bytes", stats.msgqBytes)
+                || reader.field(k, "xmit_msgq_cnt", stats.xmitMsgqCnt) || reader.field(k, "xmit_msgq_bytes", stats.xmitMsgqBytes)
+                || reader.field(k, "fetchq_cnt", stats.fetchqCnt) || reader.field(k, "fetchq_size", stats.fetchqSize)
+                || reader.field(k, "committed_offset", stats.committedOffset)
+                || reader.field(k, "lo_offset", stats.loOffset) || reader.field(k, "hi_offset", stats.hiOffset) || reader.field(k, "ls_offset", stats.lsOffset)
+                || reader.field(k, "consumer_lag", stats.consumerLag)
+                || reader.field(k, "txmsgs", stats.txmsgs) || reader.field(k, "txbytes", stats.txbytes)
+                || reader.field(k, "rxmsgs", stats.rxmsgs) || reader.field(k, "rxbytes", stats.rxbytes)
+                || reader.field(k, "msgs_inflight", stats.msgsInflight)
+                || reader.skip();
+        });
+    });
+
+    partitions.resize(count);
+}
+
+} // end of KAFKA_API
+
@@ -55,6 +55,83 @@ public:
      */
     static const constexpr char* MAX_POLL_RECORDS        = "max.poll.records";
 
+    /**
+     * This controls the maximum bytes (keys and values) of records that a single call to poll() will return.
+     * Note: 1) The records beyond the budget would be kept (not dropped), and returned by the next poll.
+     *       2) At least one record would be returned, even if it's larger than the budget.
+     * Default value: 0 (no limit, -- only `max.poll.records` works)
+     */
+    static const constexpr char* MAX_POLL_BYTES          = "max.poll.bytes";
+
+    /**
+     * Enable the adaptive batch size for poll(), with the lower bound (while `max.poll.records` is the upper bound).
+     * The batch size would be adjusted for each poll, with the observed processing time per record, the target poll interval, and the current lag,
+     *   -- larger batches while catching up (for throughput), and smaller ones while caught up (for latency).
+     * Default value: 0 (disabled, -- i.e, always `max.poll.records`)
+     */
+    static const constexpr char* ADAPTIVE_MAX_POLL_RECORDS_MIN = "adaptive.max.poll.records.min";
+
+    /**
+     * The target interval (in milliseconds) between polls, -- the adaptive batch size would be limited to the records which could be processed within it.
+     * Note: It's supposed to be much smaller than `max.poll.interval.ms`.
+     * Default value: 1000
+     */
+    static const constexpr char* ADAPTIVE_MAX_POLL_RECORDS_TARGET_INTERVAL_MS = "adaptive.max.poll.records.target.interval.ms";
+
+    /**
+     * Pause a partition, once the in-flight records (returned by polls, but not released with `KafkaConsumer::release()` yet) reach this number.
+     * Note: Once enabled (with either records or bytes), the application must release every polled record after it's processed.
+     * Default value: 0 (no limit)
+     */
+    static const constexpr char* FLOW_CONTROL_HIGH_WATERMARK_RECORDS = "flow.control.high.watermark.records";
+
+    /**
+     * Resume a paused partition, once the in-flight records fall to this number.
+     * Default value: half of `flow.control.high.watermark.records`
+     */
+    static const constexpr char* FLOW_CONTROL_LOW_WATERMARK_RECORDS  = "flow.control.low.watermark.records";
+
+    /**
+     * Pause a partition, once the in-flight bytes (keys and values) reach this number.
+     * Default value: 0 (no limit)
+     */
+    static const constexpr char* FLOW_CONTROL_HIGH_WATERMARK_BYTES   = "flow.control.high.watermark.bytes";
+
+    /**
+     * Resume a paused partition, once the in-flight bytes fall to this number.
+     * Default value: half of `flow.control.high.watermark.bytes`
+     */
+    static const constexpr char* FLOW_CONTROL_LOW_WATERMARK_BYTES    = "flow.control.low.watermark.bytes";
+
+    /**
+     * The interval (in milliseconds) to merge offset commits before sending a single OffsetCommit request.
+     * For KafkaAutoCommitConsumer, it's the offsets returned by the last polls; For KafkaManualCommitConsumer, it's the `commitAsync` requests.
+     * Note: The pending offsets would always be committed (synchronously) while partitions are revoked or the consumer is closed.
+     * Default value: 0 (no coalescing, -- i.e, one OffsetCommit request per poll/commitAsync)
+     */
+    static const constexpr char* COMMIT_COALESCING_INTERVAL_MS     = "commit.coalescing.interval.ms";
+
+    /**
+     * Send the coalesced offsets before the interval elapsed, once the accumulated offsets (for all partitions) advanced by this value (or more).
+     * Default value: 0 (no such threshold)
+     */
+    static const constexpr char* COMMIT_COALESCING_MAX_OFFSET_DELTA = "commit.coalescing.max.offset.delta";
+
+    /**
+     * The interval (in milliseconds) to take a snapshot of the consumer lags (within `poll()`), which could be fetched with `lagSnapshot()`.
+     * Note: The lags are calculated with the high watermarks cached locally, thus no request would be sent to brokers.
+     * Default value: 0 (no snapshot)
+     */
+    static const constexpr char* LAG_SNAPSHOT_INTERVAL_MS = "lag.snapshot.interval.ms";
+
+    /**
+     * The name of one or more partition assignment strategies (splitted by ",").
+     * Note: With "cooperative-sticky", partitions would be assigned/revoked incrementally (i.e, the other partitions keep being consumed during the rebalance).
+     * Available options: range, roundrobin, cooperative-sticky
+     * Default value: range,roundrobin
+     */
+    static const constexpr char* PARTITION_ASSIGNMENT_STRATEGY = "partition.assignment.strategy";
+
     /**
      * Minimum number of messages per topic/partition tries to maintain in the local consumer queue.
      * Note: With a larger value configured, the consumer would send FetchRequest towards brokers more frequently.
@@ -90,6 +167,12 @@ public:
      * The client's Kerberos principal name.
      */
     static const constexpr char* SASL_KERBEROS_SERVICE_NAME = "sasl.kerberos.service.name";
+
+    /**
+     * Cache the metadata (fetched with `fetchBrokerMetadata()`) for such a time-to-live, and refresh it in the background before it expires.
+     * Default value: 0 (no cache)
+     */
+    static const constexpr char* METADATA_CACHE_TTL_MS      = "metadata.cache.ttl.ms";
 };
 
 }
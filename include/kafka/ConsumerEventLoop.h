@@ -0,0 +1,190 @@
+#pragma once
+
+#include "kafka/Project.h"
+
+#ifdef KAFKA_API_ENABLE_COROUTINE
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <poll.h>
+#include <utility>
+#include <vector>
+
+
+namespace KAFKA_API {
+
+/**
+ * A single-threaded event loop, which resumes the coroutines (e.g, `co_await consumer.nextBatch(loop)`) once the file descriptors they're waiting on become readable.
+ * Thus one thread could multiplex many consumers, instead of blocking a thread for each of them.
+ * Note: It's not thread-safe, -- the loop and all the coroutines driven by it should be within the same thread.
+ */
+class ConsumerEventLoop
+{
+public:
+    /**
+     * A coroutine type (started eagerly, and never awaited), for the coroutines driven by the loop.
+     * Note: An exception escaped from the coroutine would be kept (instead of being thrown to whoever resumed it, e.g, `run()`),
+     *       and rethrown by `Task::get()`. The coroutine frame is destroyed once it finishes, either way.
+     */
+    class Task
+    {
+    public:
+        struct State
+        {
+            bool               done = false;
+            std::exception_ptr exception;
+        };
+
+        struct promise_type
+        {
+            std::shared_ptr<State> state = std::make_shared<State>();
+
+            Task get_return_object() noexcept             { return Task(state); }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept   { return {}; }
+            void return_void() noexcept                   { state->done = true; }
+            void unhandled_exception() noexcept           { state->exception = std::current_exception(); state->done = true; }
+        };
+
+        Task() = default;
+
+        /**
+         * Whether the coroutine has finished (or exited with an exception).
+         */
+        bool done() const { return _state && _state->done; }
+
+        /**
+         * Rethrow the exception which escaped from the coroutine (if any).
+         */
+        void get() const
+        {
+            if (_state && _state->exception) std::rethrow_exception(_state->exception);
+        }
+
+    private:
+        explicit Task(std::shared_ptr<State> state): _state(std::move(state)) {}
+
+        std::shared_ptr<State> _state;
+    };
+
+    ConsumerEventLoop() = default;
+    ConsumerEventLoop(const ConsumerEventLoop&) = delete;
+    ConsumerEventLoop& operator=(const ConsumerEventLoop&) = delete;
+
+    /**
+     * Suspend the coroutine until `fd` is readable and `tryComplete()` returns true (or the loop is stopped).
+     * Note: It's used by the awaitables, -- not supposed to be called by the application directly.
+     */
+    void wait(int fd, std::function<bool()> tryComplete, std::coroutine_handle<> handle)
+    {
+        _waiters.push_back(Waiter{fd, std::move(tryComplete), handle});
+    }
+
+    /**
+     * Wait (up to `timeout`) for the file descriptors, and resume the coroutines which are ready.
+     * Returns the number of coroutines resumed.
+     */
+    std::size_t runOnce(std::chrono::milliseconds timeout);
+
+    /**
+     * Keep resuming the coroutines, until `stop()` is called, or no coroutine is waiting.
+     */
+    void run();
+
+    /**
+     * Stop the loop, -- all the waiting coroutines would be resumed (with nothing fetched), thus they could finish.
+     */
+    void stop();
+
+    /**
+     * Whether the loop has been stopped.
+     */
+    bool stopped() const { return _stopped; }
+
+    /**
+     * Number of coroutines waiting.
+     */
+    std::size_t waiting() const { return _waiters.size(); }
+
+private:
+    static constexpr int POLL_INTERVAL_MS = 100;
+
+    struct Waiter
+    {
+        int                     fd;
+        std::function<bool()>   tryComplete;
+        std::coroutine_handle<> handle;
+    };
+
+    std::vector<Waiter> _waiters;
+    bool                _stopped = false;
+};
+
+inline std::size_t
+ConsumerEventLoop::runOnce(std::chrono::milliseconds timeout)
+{
+    if (_waiters.empty()) return 0;
+
+    std::vector<struct pollfd> pfds;
+    pfds.reserve(_waiters.size());
+    for (const auto& waiter: _waiters)
+    {
+        pfds.push_back({waiter.fd, POLLIN, 0});
+    }
+
+    if (poll(pfds.data(), pfds.size(), static_cast<int>(timeout.count())) <= 0) return 0;
+
+    // Pick up the ready ones first, -- the resumed coroutines might append new waiters
+    std::vector<std::coroutine_handle<>> toResume;
+    std::vector<Waiter> stillWaiting;
+    for (std::size_t i = 0; i < _waiters.size(); ++i)
+    {
+        if ((pfds[i].revents & (POLLIN | POLLERR | POLLHUP)) && _waiters[i].tryComplete())
+        {
+            toResume.push_back(_waiters[i].handle);
+        }
+        else
+        {
+            stillWaiting.push_back(std::move(_waiters[i]));
+        }
+    }
+    _waiters.swap(stillWaiting);
+
+    for (auto handle: toResume)
+    {
+        handle.resume();
+    }
+
+    return toResume.size();
+}
+
+inline void
+ConsumerEventLoop::run()
+{
+    while (!_stopped && !_waiters.empty())
+    {
+        runOnce(std::chrono::milliseconds(POLL_INTERVAL_MS));
+    }
+}
+
+inline void
+ConsumerEventLoop::stop()
+{
+    _stopped = true;
+
+    // The resumed coroutines would see `stopped()`, thus never wait again
+    std::vector<Waiter> waiters;
+    waiters.swap(_waiters);
+    for (auto& waiter: waiters)
+    {
+        waiter.handle.resume();
+    }
+}
+
+} // end of KAFKA_API
+
+#endif // KAFKA_API_ENABLE_COROUTINE
+
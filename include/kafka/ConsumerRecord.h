@@ -9,6 +9,9 @@
 
 #include "librdkafka/rdkafka.h"
 
+#include <array>
+#include <cstring>
+#include <iterator>
 #include <sstream>
 
 
@@ -69,6 +72,76 @@ public:
      */
     Header::Value lastHeaderValue(const Header::Key& key);
 
+    /**
+     * A lightweight (non-owning) range over the headers of a record, -- no allocation while iterating or looking up.
+     * Note: It's only valid while the record is alive.
+     */
+    class HeadersView
+    {
+    public:
+        class const_iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type        = HeaderView;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const HeaderView*;
+            using reference         = HeaderView;
+
+            const_iterator(const HeadersView& view, std::size_t idx): _view(&view), _idx(idx) {}
+
+            HeaderView      operator*()  const { return (*_view)[_idx]; }
+            const_iterator& operator++()       { ++_idx; return *this; }
+            const_iterator  operator++(int)    { const_iterator ret = *this; ++_idx; return ret; }
+
+            bool operator==(const const_iterator& other) const { return _idx == other._idx; }
+            bool operator!=(const const_iterator& other) const { return _idx != other._idx; }
+
+        private:
+            const HeadersView* _view;
+            std::size_t        _idx;
+        };
+
+        explicit HeadersView(const rd_kafka_headers_t* hdrs = nullptr): _hdrs(hdrs), _size(hdrs ? rd_kafka_header_cnt(hdrs) : 0) {}
+
+        std::size_t    size()  const { return _size; }
+        bool           empty() const { return _size == 0; }
+        const_iterator begin() const { return const_iterator(*this, 0); }
+        const_iterator end()   const { return const_iterator(*this, _size); }
+
+        /**
+         * The header at the position (which must be less than `size()`).
+         */
+        HeaderView operator[](std::size_t idx) const
+        {
+            const char* name      = nullptr;
+            const void* valuePtr  = nullptr;
+            std::size_t valueSize = 0;
+            rd_kafka_header_get_all(_hdrs, idx, &name, &valuePtr, &valueSize);
+            return HeaderView(name, Header::Value(valuePtr, valueSize));
+        }
+
+        /**
+         * Return just one (the very last) header's value for the given key (or an empty value, if not found).
+         */
+        Header::Value lastValue(const char* key) const
+        {
+            const void* valuePtr  = nullptr;
+            std::size_t valueSize = 0;
+            return (_hdrs && rd_kafka_header_get_last(_hdrs, key, &valuePtr, &valueSize) == RD_KAFKA_RESP_ERR_NO_ERROR) ?
+                   Header::Value(valuePtr, valueSize) : Header::Value();
+        }
+
+    private:
+        const rd_kafka_headers_t* _hdrs;
+        std::size_t               _size;
+    };
+
+    /**
+     * The headers of the record, -- without copying (compared with `headers()`).
+     */
+    HeadersView headersView() const;
+
     /**
      * The error.
      *
@@ -115,6 +188,13 @@ ConsumerRecord::headers() const
     return headers;
 }
 
+inline ConsumerRecord::HeadersView
+ConsumerRecord::headersView() const
+{
+    rd_kafka_headers_t* hdrs = nullptr;
+    return HeadersView(rd_kafka_message_headers(_rk_msg.get(), &hdrs) == RD_KAFKA_RESP_ERR_NO_ERROR ? hdrs : nullptr);
+}
+
 inline Header::Value
 ConsumerRecord::lastHeaderValue(const Header::Key& key)
 {
@@ -130,6 +210,66 @@ ConsumerRecord::lastHeaderValue(const Header::Key& key)
            Header::Value(valuePtr, valueSize) : Header::Value();
 }
 
+/**
+ * A small index over the headers of a record, for repeated lookups by key, -- the headers are scanned only once, and the lookups compare the key lengths first.
+ * Note: 1) Only the first `Capacity` headers are indexed (the rest would be looked up through the view), and no heap allocation is needed.
+ *       2) It's only valid while the record is alive.
+ */
+template <std::size_t Capacity = 8>
+class HeadersIndex
+{
+public:
+    explicit HeadersIndex(const ConsumerRecord::HeadersView& view): _view(view), _count(std::min(view.size(), Capacity))
+    {
+        for (std::size_t i = 0; i < _count; ++i)
+        {
+            HeaderView header = view[i];
+#if __cplusplus >= 201703L
+            _entries[i] = Entry{header.key.data(), header.key.size(), header.value};
+#else
+            _entries[i] = Entry{header.key, std::strlen(header.key), header.value};
+#endif
+        }
+    }
+
+    /**
+     * Return just one (the very last) header's value for the given key (or an empty value, if not found).
+     */
+    Header::Value lastValue(const char* key) const
+    {
+        // Headers beyond the capacity are the latest ones
+        if (_view.size() > _count)
+        {
+            for (std::size_t i = _view.size(); i > _count; --i)
+            {
+                HeaderView header = _view[i - 1];
+                if (header.keyEquals(key)) return header.value;
+            }
+        }
+
+        const std::size_t keyLen = std::strlen(key);
+        for (std::size_t i = _count; i > 0; --i)
+        {
+            const Entry& entry = _entries[i - 1];
+            if (entry.keyLen == keyLen && std::memcmp(entry.key, key, keyLen) == 0) return entry.value;
+        }
+
+        return Header::Value();
+    }
+
+private:
+    struct Entry
+    {
+        const char*   key    = nullptr;
+        std::size_t   keyLen = 0;
+        Header::Value value;
+    };
+
+    ConsumerRecord::HeadersView _view;
+    std::size_t                 _count;
+    std::array<Entry, Capacity> _entries;
+};
+
 inline std::string
 ConsumerRecord::toString() const
 {
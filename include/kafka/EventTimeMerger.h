@@ -0,0 +1,316 @@
+#pragma once
+
+#include "kafka/Project.h"
+
+#include "kafka/ConsumerRecord.h"
+#include "kafka/KafkaConsumer.h"
+#include "kafka/Timestamp.h"
+#include "kafka/Types.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+
+namespace KAFKA_API {
+
+/**
+ * Merges the records from all partitions (buffered separately), and emits them in event-time order, -- with a k-way merge over the heads of the partition buffers.
+ * A record would be emitted once every partition (assigned with `assign()`, or seen with `push()`) has some record buffered, thus the smallest event time is known.
+ *   Otherwise, it waits (for the empty partitions) with a bounded lookahead, -- until the record has been buffered for `maxLookahead`, or some partition's buffer is full.
+ * Note: 1) Within a partition, the records would always be emitted with the offset order (i.e, the ordering is approximate if the event time is not monotonic).
+ *       2) The records with errors (e.g, EOF events) would not be buffered, but emitted with the next `pop()` directly.
+ *       3) It's not thread-safe, -- it's supposed to be used within the polling thread.
+ *       4) Keep the partitions in sync with the consumer's assignment, -- e.g, call `assign()`/`discard()` within the rebalance callback.
+ *       5) The consumer would have moved past the buffered records, -- commit with `committableOffsets()`, instead of the consumer's positions (thus, no auto-commit).
+ */
+class EventTimeMerger
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * The partitions which should change the state (i.e, paused while the buffer is full, and resumed once it's drained to half).
+     */
+    struct Backpressure
+    {
+        TopicPartitions toPause;
+        TopicPartitions toResume;
+    };
+
+    EventTimeMerger(std::size_t maxBufferedRecordsPerPartition, std::chrono::milliseconds maxLookahead)
+        : _capacity(std::max<std::size_t>(maxBufferedRecordsPerPartition, 1)), _maxLookahead(maxLookahead)
+    {
+    }
+
+    /**
+     * Buffer a record, -- with its timestamp as the event time.
+     */
+    void push(ConsumerRecord&& record, Clock::time_point now = Clock::now())
+    {
+        const Timestamp::Value eventTime = record.error() ? 0 : record.timestamp().msSinceEpoch;
+        push(std::move(record), eventTime, now);
+    }
+
+    /**
+     * Buffer a record, -- with a specified event time (e.g, extracted from the payload).
+     */
+    void push(ConsumerRecord&& record, Timestamp::Value eventTime, Clock::time_point now = Clock::now());
+
+    /**
+     * Buffer the records (e.g, returned by a poll).
+     */
+    void push(std::vector<ConsumerRecord>&& records, Clock::time_point now = Clock::now())
+    {
+        for (auto& record: records) push(std::move(record), now);
+        records.clear();
+    }
+
+    /**
+     * Emit the records (appended to `output`) in event-time order, -- as many as could be emitted now.
+     * Returns the number of records emitted.
+     */
+    std::size_t pop(std::vector<ConsumerRecord>& output, Clock::time_point now = Clock::now());
+
+    /**
+     * Emit the records in event-time order, -- as many as could be emitted now.
+     */
+    std::vector<ConsumerRecord> pop(Clock::time_point now = Clock::now())
+    {
+        std::vector<ConsumerRecord> output;
+        pop(output, now);
+        return output;
+    }
+
+    /**
+     * Decide which partitions should be paused/resumed (with the buffer sizes), -- and take it for granted that the decision would be carried out.
+     */
+    Backpressure backpressure();
+
+    /**
+     * Add the partitions to merge (e.g, in the rebalance callback, after they're assigned), -- the records would wait for them (with the bounded lookahead) even before they have any record.
+     */
+    void assign(const TopicPartitions& tps)
+    {
+        for (const auto& tp: tps) _buffers.emplace(tp, PartitionBuffer());
+    }
+
+    /**
+     * Forget everything about these partitions (e.g, in the rebalance callback, after they're revoked), -- the buffered records would be dropped.
+     */
+    void discard(const TopicPartitions& tps);
+
+    /**
+     * Number of records buffered.
+     */
+    std::size_t size() const { return _size; }
+
+    /**
+     * Number of records buffered for a partition.
+     */
+    std::size_t size(const TopicPartition& tp) const
+    {
+        auto it = _buffers.find(tp);
+        return (it != _buffers.end()) ? it->second.entries.size() : 0;
+    }
+
+    /**
+     * The offsets safe to commit, -- i.e, the smallest offset not emitted yet, for each partition which has emitted (or buffered) some record.
+     */
+    TopicPartitionOffsets committableOffsets() const;
+
+    /**
+     * Poll the consumer, buffer the records, pause/resume the partitions (with the buffer sizes), and emit the records in event-time order.
+     * Note: 1) The partitions paused by the merger would be resumed with `KafkaConsumer::resume()` (and vice versa), -- thus don't mix it with other pause/resume callers.
+     *       2) Only a manual-commit consumer is accepted, -- an auto-commit one would commit the records still buffered. Commit with `committableOffsets()`.
+     */
+    std::vector<ConsumerRecord> poll(KafkaManualCommitConsumer& consumer, std::chrono::milliseconds timeout);
+
+private:
+    struct Entry
+    {
+        Timestamp::Value  eventTime;
+        Clock::time_point arrival;
+        ConsumerRecord    record;
+    };
+
+    struct PartitionBuffer
+    {
+        std::deque<Entry> entries;
+        bool              paused = false;
+        Offset            nextOffset = RD_KAFKA_OFFSET_INVALID;  // Next to the last emitted record
+    };
+
+    // The heads of the non-empty partition buffers
+    struct Head
+    {
+        Timestamp::Value      eventTime;
+        const TopicPartition* tp;
+    };
+    // Min-heap (with std::push_heap/std::pop_heap), -- ties are broken by partition, thus the output is deterministic
+    static bool laterThan(const Head& lhs, const Head& rhs)
+    {
+        return lhs.eventTime != rhs.eventTime ? lhs.eventTime > rhs.eventTime : *lhs.tp > *rhs.tp;
+    }
+
+    void pushHead(const TopicPartition& tp, Timestamp::Value eventTime)
+    {
+        _heads.push_back(Head{eventTime, &tp});
+        std::push_heap(_heads.begin(), _heads.end(), laterThan);
+    }
+
+    const std::size_t               _capacity;
+    const std::chrono::milliseconds _maxLookahead;
+
+    std::map<TopicPartition, PartitionBuffer> _buffers;
+    std::vector<Head>                         _heads;
+    std::vector<ConsumerRecord>               _passthrough;
+    std::size_t                               _size      = 0;
+    std::size_t                               _fullCount = 0;
+};
+
+inline void
+EventTimeMerger::push(ConsumerRecord&& record, Timestamp::Value eventTime, Clock::time_point now)
+{
+    if (record.error())
+    {
+        _passthrough.emplace_back(std::move(record));
+        return;
+    }
+
+    auto it = _buffers.find(TopicPartition(record.topic(), record.partition()));
+    if (it == _buffers.end())
+    {
+        it = _buffers.emplace(TopicPartition(record.topic(), record.partition()), PartitionBuffer()).first;
+    }
+
+    std::deque<Entry>& entries = it->second.entries;
+    if (entries.empty()) pushHead(it->first, eventTime);
+
+    entries.push_back(Entry{eventTime, now, std::move(record)});
+    ++_size;
+
+    if (entries.size() == _capacity) ++_fullCount;
+}
+
+inline std::size_t
+EventTimeMerger::pop(std::vector<ConsumerRecord>& output, Clock::time_point now)
+{
+    const std::size_t origSize = output.size();
+
+    for (auto& record: _passthrough) output.emplace_back(std::move(record));
+    _passthrough.clear();
+
+    while (!_heads.empty())
+    {
+        const Head head = _heads.front();
+        PartitionBuffer&   buffer  = _buffers[*head.tp];
+        std::deque<Entry>& entries = buffer.entries;
+
+        // The smallest event time is known only if every partition has some record buffered,
+        //   -- otherwise, wait for the empty partitions (with the bounded lookahead)
+        const bool allBuffered = (_heads.size() == _buffers.size());
+        if (!allBuffered && _fullCount == 0 && now - entries.front().arrival < _maxLookahead) break;
+
+        std::pop_heap(_heads.begin(), _heads.end(), laterThan);
+        _heads.pop_back();
+
+        if (entries.size() == _capacity) --_fullCount;
+
+        buffer.nextOffset = entries.front().record.offset() + 1;
+        output.emplace_back(std::move(entries.front().record));
+        entries.pop_front();
+        --_size;
+
+        if (!entries.empty()) pushHead(*head.tp, entries.front().eventTime);
+    }
+
+    return output.size() - origSize;
+}
+
+inline EventTimeMerger::Backpressure
+EventTimeMerger::backpressure()
+{
+    Backpressure backpressure;
+    for (auto& buffer: _buffers)
+    {
+        PartitionBuffer& partitionBuffer = buffer.second;
+        if (!partitionBuffer.paused && partitionBuffer.entries.size() >= _capacity)
+        {
+            partitionBuffer.paused = true;
+            backpressure.toPause.emplace(buffer.first);
+        }
+        else if (partitionBuffer.paused && partitionBuffer.entries.size() <= _capacity / 2)
+        {
+            partitionBuffer.paused = false;
+            backpressure.toResume.emplace(buffer.first);
+        }
+    }
+    return backpressure;
+}
+
+inline void
+EventTimeMerger::discard(const TopicPartitions& tps)
+{
+    for (const auto& tp: tps)
+    {
+        auto it = _buffers.find(tp);
+        if (it == _buffers.end()) continue;
+
+        const std::size_t numEntries = it->second.entries.size();
+        _size -= numEntries;
+        if (numEntries >= _capacity) --_fullCount;
+
+        _heads.erase(std::remove_if(_heads.begin(), _heads.end(), [&it](const Head& head) { return head.tp == &it->first; }), _heads.end());
+
+        _buffers.erase(it);
+    }
+
+    std::make_heap(_heads.begin(), _heads.end(), laterThan);
+
+    _passthrough.erase(std::remove_if(_passthrough.begin(), _passthrough.end(),
+                                      [&tps](const ConsumerRecord& record) { return tps.count(TopicPartition(record.topic(), record.partition())) > 0; }),
+                       _passthrough.end());
+}
+
+inline TopicPartitionOffsets
+EventTimeMerger::committableOffsets() const
+{
+    TopicPartitionOffsets tpos;
+    for (const auto& buffer: _buffers)
+    {
+        const PartitionBuffer& partitionBuffer = buffer.second;
+        if (!partitionBuffer.entries.empty())
+        {
+            // Within a partition, the records are buffered with the offset order
+            tpos.emplace(buffer.first, partitionBuffer.entries.front().record.offset());
+        }
+        else if (partitionBuffer.nextOffset != RD_KAFKA_OFFSET_INVALID)
+        {
+            tpos.emplace(buffer.first, partitionBuffer.nextOffset);
+        }
+    }
+    return tpos;
+}
+
+inline std::vector<ConsumerRecord>
+EventTimeMerger::poll(KafkaManualCommitConsumer& consumer, std::chrono::milliseconds timeout)
+{
+    push(consumer.poll(timeout));
+
+    std::vector<ConsumerRecord> output;
+    pop(output);
+
+    const Backpressure decision = backpressure();
+    if (!decision.toPause.empty())  consumer.pause(decision.toPause);
+    if (!decision.toResume.empty()) consumer.resume(decision.toResume);
+
+    return output;
+}
+
+} // end of KAFKA_API
+
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "kafka/Project.h"
+
+#include "kafka/Types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+
+namespace KAFKA_API {
+
+/**
+ * Tracks the in-flight records (i.e, returned by polls, but not released by the processing stage yet) for each partition,
+ *   and decides which partitions should be paused (once the records/bytes in flight exceed the high watermark) or resumed (once both fall below the low watermark).
+ * Note: 1) A zero high watermark means no limit (for records, or bytes).
+ *       2) `release()` is thread-safe (i.e, could be called by the processing stage, with any thread), while the others are supposed to be called by the polling thread.
+ */
+class FlowController
+{
+public:
+    /**
+     * The thresholds to pause/resume a partition.
+     */
+    struct Watermarks
+    {
+        std::uint64_t high = 0;
+        std::uint64_t low  = 0;
+    };
+
+    /**
+     * The records/bytes in flight for a partition.
+     */
+    struct InFlight
+    {
+        std::uint64_t records = 0;
+        std::uint64_t bytes   = 0;
+    };
+
+    /**
+     * The partitions which should change the state.
+     */
+    struct Decision
+    {
+        TopicPartitions toPause;
+        TopicPartitions toResume;
+    };
+
+    FlowController(Watermarks records, Watermarks bytes): _records(records), _bytes(bytes) {}
+
+    /**
+     * Whether the in-flight records would be tracked or not.
+     */
+    bool isEnabled() const { return _records.high > 0 || _bytes.high > 0; }
+
+    /**
+     * Account a record (with its size) as in-flight, -- after it's returned by a poll.
+     */
+    void acquire(const TopicPartition& tp, std::size_t bytes);
+
+    /**
+     * The records (with total size) are no longer in flight, -- after they've been processed.
+     * Note: 1) It's thread-safe.
+     *       2) It would be ignored if the partition has been discarded (e.g, revoked), and not re-assigned yet.
+     *          Once re-assigned, the releases (for the records polled before) could not be told apart from the new ones, -- thus they'd be counted against the new assignment,
+     *          which might resume the partition earlier, but never keeps it paused (even if the records polled before are dropped without being released).
+     */
+    void release(const TopicPartition& tp, std::size_t records, std::size_t bytes);
+
+    /**
+     * Decide which partitions should be paused/resumed, -- and take it for granted that the decision would be carried out.
+     */
+    Decision update();
+
+    /**
+     * Forget everything about these partitions (e.g, after they're revoked).
+     */
+    void discard(const TopicPartitions& tps);
+
+    /**
+     * The partitions paused by the flow control.
+     */
+    TopicPartitions paused() const;
+
+    /**
+     * The records/bytes in flight for a partition.
+     */
+    InFlight inFlight(const TopicPartition& tp) const;
+
+private:
+    struct PartitionState
+    {
+        InFlight inFlight;
+        bool     paused = false;
+    };
+
+    bool aboveHighWatermark(const InFlight& inFlight) const
+    {
+        return (_records.high > 0 && inFlight.records >= _records.high) || (_bytes.high > 0 && inFlight.bytes >= _bytes.high);
+    }
+
+    bool belowLowWatermark(const InFlight& inFlight) const
+    {
+        return (_records.high == 0 || inFlight.records <= _records.low) && (_bytes.high == 0 || inFlight.bytes <= _bytes.low);
+    }
+
+    const Watermarks _records;
+    const Watermarks _bytes;
+
+    mutable std::mutex                       _lock;
+    std::map<TopicPartition, PartitionState> _partitions;
+};
+
+inline void
+FlowController::acquire(const TopicPartition& tp, std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    InFlight& inFlight = _partitions[tp].inFlight;
+    inFlight.records += 1;
+    inFlight.bytes   += bytes;
+}
+
+inline void
+FlowController::release(const TopicPartition& tp, std::size_t records, std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    auto it = _partitions.find(tp);
+    if (it == _partitions.end()) return;
+
+    InFlight& inFlight = it->second.inFlight;
+    inFlight.records -= std::min<std::uint64_t>(inFlight.records, records);
+    inFlight.bytes   -= std::min<std::uint64_t>(inFlight.bytes,   bytes);
+}
+
+inline FlowController::Decision
+FlowController::update()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    Decision decision;
+    for (auto& partition: _partitions)
+    {
+        PartitionState& state = partition.second;
+        if (!state.paused && aboveHighWatermark(state.inFlight))
+        {
+            state.paused = true;
+            decision.toPause.emplace(partition.first);
+        }
+        else if (state.paused && belowLowWatermark(state.inFlight))
+        {
+            state.paused = false;
+            decision.toResume.emplace(partition.first);
+        }
+    }
+    return decision;
+}
+
+inline void
+FlowController::discard(const TopicPartitions& tps)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    for (const auto& tp: tps)
+    {
+        _partitions.erase(tp);
+    }
+}
+
+inline TopicPartitions
+FlowController::paused() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    TopicPartitions tps;
+    for (const auto& partition: _partitions)
+    {
+        if (partition.second.paused) tps.emplace(partition.first);
+    }
+    return tps;
+}
+
+inline FlowController::InFlight
+FlowController::inFlight(const TopicPartition& tp) const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    auto it = _partitions.find(tp);
+    return (it != _partitions.end()) ? it->second.inFlight : InFlight();
+}
+
+} // end of KAFKA_API
+
@@ -5,9 +5,14 @@
 #include "kafka/Types.h"
 
 #include <algorithm>
+#include <cstring>
 #include <string>
 #include <vector>
 
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
 
 namespace KAFKA_API {
 
@@ -34,6 +39,48 @@ struct Header
     Value value;
 };
 
+/**
+ * A non-owning view of a message header (e.g, within a ConsumerRecord), -- no allocation for the key.
+ * Note: It's only valid while the record (which holds the header) is alive.
+ */
+struct HeaderView
+{
+#if __cplusplus >= 201703L
+    using Key   = std::string_view;
+#else
+    using Key   = const char*;  // NUL-terminated
+#endif
+    using Value = Header::Value;
+
+    HeaderView() = default;
+    HeaderView(Key k, Value v): key(k), value(v) {}
+
+    /**
+     * Whether the header's key equals to the given one.
+     */
+    bool keyEquals(const char* k) const
+    {
+#if __cplusplus >= 201703L
+        return key == k;
+#else
+        return std::strcmp(key, k) == 0;
+#endif
+    }
+
+    /**
+     * Copy it to an owning Header.
+     */
+    Header toHeader() const { return Header(Header::Key(key), value); }
+
+    /**
+    * Obtains explanatory string.
+    */
+    std::string toString() const { return toHeader().toString(); }
+
+    Key   key{};
+    Value value;
+};
+
 /**
  * Message Headers.
  */
@@ -3,9 +3,11 @@
 #include "kafka/Project.h"
 
 #include "kafka/BrokerMetadata.h"
+#include "kafka/ClientStatistics.h"
 #include "kafka/Error.h"
 #include "kafka/KafkaException.h"
 #include "kafka/Logger.h"
+#include "kafka/MetadataCache.h"
 #include "kafka/Properties.h"
 #include "kafka/RdKafkaHelper.h"
 #include "kafka/Types.h"
@@ -15,12 +17,18 @@
 #include <atomic>
 #include <cassert>
 #include <climits>
+#include <cstdint>
+#include <fcntl.h>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
 #include <string>
 #include <syslog.h>
 #include <thread>
+#include <unistd.h>
+#include <vector>
 
 
 namespace KAFKA_API {
@@ -33,6 +41,7 @@ class KafkaClient
 protected:
     using ConfigCallbacksRegister = std::function<void(rd_kafka_conf_t*)>;
     using StatsCallback           = std::function<void(std::string)>;
+    using StatisticsCallback      = std::function<void(const ClientStatistics&)>;
 
     enum class ClientType { KafkaConsumer, KafkaProducer, AdminClient };
     static std::string getClientTypeString(ClientType type)
@@ -92,6 +101,13 @@ public:
      */
     void setStatsCallback(StatsCallback cb) { _statsCb = std::move(cb); }
 
+    /**
+     * Set callback to receive the periodic statistics info, -- parsed into the typed `ClientStatistics` (without copying the JSON).
+     * Note: 1) It only works while the "statistics.interval.ms" property is configured with a non-0 value.
+     *       2) The `ClientStatistics` is reused for the following callbacks, -- copy it if it's needed after the callback returns.
+     */
+    void setStatisticsCallback(StatisticsCallback cb) { _statisticsCb = std::move(cb); }
+
     /**
      * Return the properties which took effect.
      */
@@ -104,11 +120,38 @@ public:
 
     /**
      * Fetch matadata from a available broker.
+     * Note: With the "metadata.cache.ttl.ms" property configured, the metadata would be served from a client-level cache (and refreshed in the background before it expires).
      */
     Optional<BrokerMetadata> fetchBrokerMetadata(const std::string& topic,
                                                  std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_METADATA_TIMEOUT_MS),
                                                  bool disableErrorLogging = false);
 
+    /**
+     * Fetch matadata for a batch of topics, -- with a single MetadataRequest.
+     * Note: 1) The topics which failed to get the metadata (e.g, not exist) would not be in the result.
+     *       2) The request would cover every topic this client has ever touched (not only the specified ones), -- though only the specified ones are returned.
+     */
+    std::map<Topic, BrokerMetadata> fetchBrokerMetadata(const Topics& topics,
+                                                        std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_METADATA_TIMEOUT_MS),
+                                                        bool disableErrorLogging = false);
+
+    /**
+     * Send a MetadataRequest for the topics (bypassing the cache), -- librdkafka would pick up the changes (e.g, new partitions) with the response as well,
+     *   thus the producer could send records to the new partitions right after (instead of waiting for the periodic refresh with "topic.metadata.refresh.interval.ms").
+     */
+    std::map<Topic, BrokerMetadata> refreshBrokerMetadata(const Topics& topics,
+                                                          std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_METADATA_TIMEOUT_MS))
+    {
+        for (const auto& topic: topics) invalidateBrokerMetadata(topic);
+        return fetchBrokerMetadata(topics, timeout);
+    }
+
+    /**
+     * Drop the cached metadata for a topic, -- thus the next `fetchBrokerMetadata()` would send a request to the brokers.
+     * Note: It's done internally while getting errors such as NOT_LEADER_FOR_PARTITION/UNKNOWN_TOPIC_OR_PART (for delivery reports, or polled records).
+     */
+    void invalidateBrokerMetadata(const std::string& topic) { if (_metadataCache) _metadataCache->invalidate(topic); }
+
     template<class ...Args>
     void doLog(int level, const char* filename, int lineno, const char* format, Args... args) const
     {
@@ -175,6 +218,36 @@ protected:
     // Validate properties (and fix it if necesary)
     static Properties validateAndReformProperties(const Properties& origProperties);
 
+    // Whether the error means the cached metadata for the topic is out of date
+    static bool isStaleMetadataError(rd_kafka_resp_err_t err)
+    {
+        return err == RD_KAFKA_RESP_ERR_NOT_LEADER_FOR_PARTITION || err == RD_KAFKA_RESP_ERR_LEADER_NOT_AVAILABLE
+               || err == RD_KAFKA_RESP_ERR_UNKNOWN_TOPIC_OR_PART || err == RD_KAFKA_RESP_ERR__UNKNOWN_TOPIC || err == RD_KAFKA_RESP_ERR__UNKNOWN_PARTITION;
+    }
+
+    bool isBrokerMetadataCached() const { return static_cast<bool>(_metadataCache); }
+
+    // Stop the metadata cache (with its refresh thread), -- supposed to be called at the beginning of `close()` (or the destructor) of the derived classes,
+    //   thus no refresh would be running while they're tearing down
+    //   Note: It's not synchronized with `invalidateBrokerMetadata()`, -- the derived classes must join their own threads (e.g, the polling thread) before calling it
+    void stopBrokerMetadataCache() { _metadataCache.reset(); }
+
+    // Parse the value of a numeric property (0, if it's not there)
+    static std::uint64_t parseNumberProperty(const Properties& properties, const char* key);
+
+    // The MetadataResponse, -- with the topics picked up (from `rk_metadata->topics`) if they were requested
+    struct TopicsMetadata
+    {
+        rd_kafka_resp_err_t                         error = RD_KAFKA_RESP_ERR_NO_ERROR;
+        rd_kafka_metadata_unique_ptr                rk_metadata;
+        std::vector<const rd_kafka_metadata_topic*> topics;
+    };
+
+    // Send one MetadataRequest for the topics (or for all topics, with a null `topics`)
+    // Note: librdkafka could only request for all topics, or for the "locally known topics", -- i.e, every topic this handle has ever touched
+    //       (e.g, produced to, subscribed, or requested metadata for), not only the ones requested this time. Thus the response is filtered.
+    TopicsMetadata fetchTopicsMetadata(const Topics* topics, std::chrono::milliseconds timeout);
+
     // To avoid double-close
     bool _opened = false;
 
@@ -185,13 +258,24 @@ private:
     Logger              _logger;
     Properties          _properties;
     StatsCallback       _statsCb;
+    StatisticsCallback  _statisticsCb;
+    ClientStatistics    _statistics;
     rd_kafka_unique_ptr _rk;
 
+    // Declared after `_rk`, -- thus the refresh thread would be stopped before the handle is destroyed
+    std::unique_ptr<MetadataCache> _metadataCache;
+
     // Log callback (for class instance)
     void onLog(int level, const char* fac, const char* buf) const;
 
     // Stats callback (for class instance)
-    void onStats(std::string&& jsonString);
+    void onStats(const char* jsonStrBuf, std::size_t jsonStrLen);
+
+    // Send a MetadataRequest for the topic
+    Optional<BrokerMetadata> fetchBrokerMetadataFromBroker(const std::string& topic, std::chrono::milliseconds timeout, bool disableErrorLogging);
+
+    // Construct the BrokerMetadata for a topic within the MetadataResponse
+    Optional<BrokerMetadata> constructBrokerMetadata(const rd_kafka_metadata_t* rk_metadata, const rd_kafka_metadata_topic& metadata_topic, bool disableErrorLogging) const;
 
     static const constexpr char* BOOTSTRAP_SERVERS = "bootstrap.servers";
     static const constexpr char* CLIENT_ID         = "client.id";
@@ -199,6 +283,7 @@ private:
     static const constexpr char* DEBUG             = "debug";
     static const constexpr char* SECURITY_PROTOCOL          = "security.protocol";
     static const constexpr char* SASL_KERBEROS_SERVICE_NAME = "sasl.kerberos.service.name";
+    static const constexpr char* METADATA_CACHE_TTL_MS      = "metadata.cache.ttl.ms";
 
 #if __cplusplus >= 201703L
     static constexpr int DEFAULT_METADATA_TIMEOUT_MS = 10000;
@@ -260,6 +345,72 @@ protected:
         std::atomic_bool _running;
         std::thread      _thread;
     };
+
+    /**
+     * A pipe which would be written (by librdkafka) once the queue turns from empty to non-empty.
+     * Thus the read end could be watched by an event loop (e.g, epoll/select/asio), instead of polling the queue with a thread.
+     */
+    class IoEventNotifier
+    {
+    public:
+        explicit IoEventNotifier(rd_kafka_queue_t* queue): _queue(queue)
+        {
+            if (pipe(_fds) != 0)
+            {
+                KAFKA_THROW_WITH_MSG(RD_KAFKA_RESP_ERR__CRIT_SYS_RESOURCE, std::string("Failed to create pipe! errno[") + std::to_string(errno) + "]");
+            }
+
+            for (auto fd: _fds)
+            {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK); // NOLINT
+                fcntl(fd, F_SETFD, FD_CLOEXEC);                      // NOLINT
+            }
+
+            rd_kafka_queue_io_event_enable(_queue, _fds[1], IO_EVENT_PAYLOAD, 1);
+        }
+
+        ~IoEventNotifier()
+        {
+            // Must be disabled before closing the pipe, -- otherwise, librdkafka might write to a reused fd
+            rd_kafka_queue_io_event_enable(_queue, -1, nullptr, 0);
+
+            close(_fds[0]);
+            close(_fds[1]);
+        }
+
+        IoEventNotifier(const IoEventNotifier&) = delete;
+        IoEventNotifier& operator=(const IoEventNotifier&) = delete;
+
+        /**
+         * The read end of the pipe.
+         */
+        int fd() const { return _fds[0]; }
+
+        /**
+         * Consume all the notifications (since the queue would be served right after).
+         */
+        void clear() const
+        {
+            char buf[64];
+            while (read(_fds[0], buf, sizeof(buf)) > 0) {}
+        }
+
+        /**
+         * Re-arm the notification, -- while the queue has not been served empty.
+         * Note: librdkafka only writes the pipe while the queue turns from empty to non-empty.
+         */
+        void notify() const
+        {
+            // The pipe might be full (i.e, already readable), -- nothing to worry about
+            if (write(_fds[1], IO_EVENT_PAYLOAD, 1) < 0) {}
+        }
+
+    private:
+        static constexpr const char* IO_EVENT_PAYLOAD = "1";
+
+        rd_kafka_queue_t* _queue;
+        int               _fds[2] = {-1, -1};
+    };
 };
 
 template <typename T>
@@ -309,7 +460,7 @@ KafkaClient::KafkaClient(ClientType                     clientType,
     for (const auto& prop: properties.map())
     {
         // Those private properties are only available for `C++ wrapper`, not for librdkafka
-        if (privatePropertyKeys.count(prop.first))
+        if (privatePropertyKeys.count(prop.first) || prop.first == METADATA_CACHE_TTL_MS)
         {
             _properties.put(prop.first, prop.second);
             continue;
@@ -356,9 +507,38 @@ KafkaClient::KafkaClient(ClientType                     clientType,
                              "No broker could be added successfully, BOOTSTRAP_SERVERS=[" + *brokers + "]");
     }
 
+    // Metadata cache
+    const std::uint64_t metadataCacheTtlMs = parseNumberProperty(properties, METADATA_CACHE_TTL_MS);
+    if (metadataCacheTtlMs > 0)
+    {
+        _metadataCache = std::make_unique<MetadataCache>(std::chrono::milliseconds(metadataCacheTtlMs),
+                                                         [this](const Topic& topic, std::chrono::milliseconds timeout) {
+                                                             return fetchBrokerMetadataFromBroker(topic, timeout, false);
+                                                         });
+    }
+
     _opened = true;
 }
 
+inline std::uint64_t
+KafkaClient::parseNumberProperty(const Properties& properties, const char* key)
+{
+    auto value = properties.getProperty(key);
+    if (!value) return 0;
+
+    try
+    {
+        // `std::stoull()` would take a negative number (e.g, "-1") as a huge one
+        if (value->find('-') != std::string::npos) throw std::invalid_argument("negative");
+
+        return std::stoull(*value);
+    }
+    catch (const std::exception& e)
+    {
+        KAFKA_THROW_WITH_MSG(RD_KAFKA_RESP_ERR__INVALID_ARG, std::string("Invalid ").append(key).append("[").append(*value).append("], which must be an number!").append(e.what()));
+    }
+}
+
 inline Properties
 KafkaClient::validateAndReformProperties(const Properties& origProperties)
 {
@@ -449,20 +629,47 @@ KafkaClient::logCallback(const rd_kafka_t* rk, int level, const char* fac, const
 }
 
 inline void
-KafkaClient::onStats(std::string&& jsonString)
+KafkaClient::onStats(const char* jsonStrBuf, std::size_t jsonStrLen)
 {
-    if (_statsCb) _statsCb(std::move(jsonString));
+    if (_statisticsCb)
+    {
+        if (_statistics.parse(jsonStrBuf, jsonStrLen))
+        {
+            _statisticsCb(_statistics);
+        }
+        else
+        {
+            KAFKA_API_DO_LOG(LOG_ERR, "failed to parse the statistics JSON");
+        }
+    }
+
+    if (_statsCb) _statsCb(std::string(jsonStrBuf, jsonStrBuf+jsonStrLen));
 }
 
 inline int
 KafkaClient::statsCallback(rd_kafka_t* rk, char* jsonStrBuf, size_t jsonStrLen, void* /*opaque*/)
 {
-    kafkaClient(rk).onStats(std::string(jsonStrBuf, jsonStrBuf+jsonStrLen));
+    kafkaClient(rk).onStats(jsonStrBuf, jsonStrLen);
     return 0;
 }
 
 inline Optional<BrokerMetadata>
 KafkaClient::fetchBrokerMetadata(const std::string& topic, std::chrono::milliseconds timeout, bool disableErrorLogging)
+{
+    if (!_metadataCache) return fetchBrokerMetadataFromBroker(topic, timeout, disableErrorLogging);
+
+    if (auto cached = _metadataCache->get(topic))
+    {
+        return Optional<BrokerMetadata>(*cached);
+    }
+
+    auto ret = fetchBrokerMetadataFromBroker(topic, timeout, disableErrorLogging);
+    if (ret) _metadataCache->put(topic, *ret);
+    return ret;
+}
+
+inline Optional<BrokerMetadata>
+KafkaClient::fetchBrokerMetadataFromBroker(const std::string& topic, std::chrono::milliseconds timeout, bool disableErrorLogging)
 {
     Optional<BrokerMetadata> ret;
     auto rkt = rd_kafka_topic_unique_ptr(rd_kafka_topic_new(getClientHandle(), topic.c_str(), nullptr));
@@ -489,18 +696,106 @@ KafkaClient::fetchBrokerMetadata(const std::string& topic, std::chrono::millisec
         return ret;
     }
 
-    const rd_kafka_metadata_topic& metadata_topic = rk_metadata->topics[0];
+    return constructBrokerMetadata(rk_metadata, rk_metadata->topics[0], disableErrorLogging);
+}
+
+inline std::map<Topic, BrokerMetadata>
+KafkaClient::fetchBrokerMetadata(const Topics& topics, std::chrono::milliseconds timeout, bool disableErrorLogging)
+{
+    std::map<Topic, BrokerMetadata> ret;
+
+    // Serve from the cache first, -- only the missing ones would be requested
+    Topics toFetch;
+    for (const auto& topic: topics)
+    {
+        auto cached = _metadataCache ? _metadataCache->get(topic) : nullptr;
+        if (cached)
+        {
+            ret.emplace(topic, *cached);
+        }
+        else
+        {
+            toFetch.emplace(topic);
+        }
+    }
+
+    if (toFetch.empty()) return ret;
+
+    const TopicsMetadata topicsMetadata = fetchTopicsMetadata(&toFetch, timeout);
+    if (topicsMetadata.error != RD_KAFKA_RESP_ERR_NO_ERROR)
+    {
+        if (!disableErrorLogging)
+        {
+            KAFKA_API_DO_LOG(LOG_ERR, "failed to get BrokerMetadata for topics[%s]! error[%s]", toString(toFetch).c_str(), rd_kafka_err2str(topicsMetadata.error));
+        }
+        return ret;
+    }
+
+    for (const auto* metadata_topic: topicsMetadata.topics)
+    {
+        if (auto metadata = constructBrokerMetadata(topicsMetadata.rk_metadata.get(), *metadata_topic, disableErrorLogging))
+        {
+            if (_metadataCache) _metadataCache->put(metadata_topic->topic, *metadata);
+
+            ret.emplace(metadata_topic->topic, std::move(*metadata));
+        }
+    }
+
+    return ret;
+}
+
+inline KafkaClient::TopicsMetadata
+KafkaClient::fetchTopicsMetadata(const Topics* topics, std::chrono::milliseconds timeout)
+{
+    // With the topic handles kept alive, a MetadataRequest for the "locally known topics" would cover all of them
+    std::vector<rd_kafka_topic_unique_ptr> rkts;
+    if (topics)
+    {
+        rkts.reserve(topics->size());
+        for (const auto& topic: *topics)
+        {
+            rkts.emplace_back(rd_kafka_topic_new(getClientHandle(), topic.c_str(), nullptr));
+        }
+    }
+
+    TopicsMetadata ret;
+
+    const rd_kafka_metadata_t* rk_metadata = nullptr;
+    ret.error = rd_kafka_metadata(getClientHandle(), topics == nullptr, nullptr, &rk_metadata, convertMsDurationToInt(timeout));
+    ret.rk_metadata.reset(rk_metadata);
+
+    if (ret.error != RD_KAFKA_RESP_ERR_NO_ERROR) return ret;
+
+    for (int i = 0; i < rk_metadata->topic_cnt; ++i)
+    {
+        const rd_kafka_metadata_topic& metadata_topic = rk_metadata->topics[i];
+
+        // Other topics known by the client might be in the response as well
+        if (topics && !topics->count(metadata_topic.topic)) continue;
+
+        ret.topics.emplace_back(&metadata_topic);
+    }
+
+    return ret;
+}
+
+inline Optional<BrokerMetadata>
+KafkaClient::constructBrokerMetadata(const rd_kafka_metadata_t* rk_metadata, const rd_kafka_metadata_topic& metadata_topic, bool disableErrorLogging) const
+{
+    Optional<BrokerMetadata> ret;
+
+    const std::string topic = metadata_topic.topic;
     if (metadata_topic.err != 0)
     {
         if (!disableErrorLogging)
         {
-            KAFKA_API_DO_LOG(LOG_ERR, "failed to construct MetaData!  topic.err[%s]", rd_kafka_err2str(metadata_topic.err));
+            KAFKA_API_DO_LOG(LOG_ERR, "failed to construct MetaData!  topic[%s], topic.err[%s]", topic.c_str(), rd_kafka_err2str(metadata_topic.err));
         }
         return ret;
     }
 
     // Construct the BrokerMetadata
-    BrokerMetadata metadata(metadata_topic.topic);
+    BrokerMetadata metadata(topic);
     metadata.setOrigNodeName(rk_metadata->orig_broker_name ? std::string(rk_metadata->orig_broker_name) : "");
 
     for (int i = 0; i < rk_metadata->broker_cnt; ++i)
@@ -514,8 +809,6 @@ KafkaClient::fetchBrokerMetadata(const std::string& topic, std::chrono::millisec
 
         Partition partition = metadata_partition.id;
 
-        BrokerMetadata::PartitionInfo partitionInfo;
-
         if (metadata_partition.err != 0)
         {
             if (!disableErrorLogging)
@@ -526,19 +819,10 @@ KafkaClient::fetchBrokerMetadata(const std::string& topic, std::chrono::millisec
             continue;
         }
 
-        partitionInfo.setLeader(metadata_partition.leader);
-
-        for (int j = 0; j < metadata_partition.replica_cnt; ++j)
-        {
-            partitionInfo.addReplica(metadata_partition.replicas[j]);
-        }
-
-        for (int j = 0; j < metadata_partition.isr_cnt; ++j)
-        {
-            partitionInfo.addInSyncReplica(metadata_partition.isrs[j]);
-        }
-
-        metadata.addPartitionInfo(partition, partitionInfo);
+        metadata.addPartition(partition,
+                              metadata_partition.leader,
+                              metadata_partition.replicas, metadata_partition.replica_cnt,
+                              metadata_partition.isrs,     metadata_partition.isr_cnt);
     }
 
     ret = metadata;
@@ -2,15 +2,20 @@
 
 #include "kafka/Project.h"
 
+#include "kafka/AdaptivePollController.h"
 #include "kafka/ConsumerConfig.h"
+#include "kafka/ConsumerEventLoop.h"
 #include "kafka/ConsumerRecord.h"
+#include "kafka/FlowController.h"
 #include "kafka/KafkaClient.h"
+#include "kafka/OffsetCommitCoalescer.h"
 
 #include "librdkafka/rdkafka.h"
 
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <deque>
 #include <functional>
 #include <iterator>
 #include <memory>
@@ -23,6 +28,8 @@ namespace Consumer
     /**
      * To identify which kind of re-balance event is handling, when the set of partitions assigned to the consumer changes.
      * It's guaranteed that rebalance callback will be called twice (first with PartitionsRevoked, and then with PartitionsAssigned).
+     * Note: With the "cooperative-sticky" assignment strategy (i.e, incremental rebalancing), the callback would only be called with the partitions which changed (the delta),
+     *       -- and either of the events might be omitted if there's nothing to revoke/assign.
      */
     enum class RebalanceEventType { PartitionsAssigned, PartitionsRevoked };
 
@@ -34,6 +41,90 @@ namespace Consumer
      * A callback interface that the user can implement to trigger custom actions when a commit request completes.
      */
     using OffsetCommitCallback = std::function<void(const TopicPartitionOffsets& topicPartitionOffsets, std::error_code ec)>;
+
+    /**
+     * The lag of a partition, -- the distance between the consumer's position and the partition's high watermark.
+     */
+    struct PartitionLag
+    {
+        /**
+         * The offset of the next record to be fetched.
+         */
+        Offset position      = RD_KAFKA_OFFSET_INVALID;
+
+        /**
+         * The high watermark (cached locally, from the latest fetch response).
+         */
+        Offset highWatermark = RD_KAFKA_OFFSET_INVALID;
+
+        /**
+         * Number of records not consumed yet (or -1, if it's unknown).
+         */
+        Offset lag() const { return (position >= 0 && highWatermark >= 0) ? std::max<Offset>(highWatermark - position, 0) : -1; }
+    };
+
+    /**
+     * The lags for partitions.
+     */
+    using LagTable = std::map<TopicPartition, PartitionLag>;
+
+    /**
+     * Sum of the (known) lags for all partitions.
+     */
+    inline Offset totalLag(const LagTable& lags)
+    {
+        Offset total = 0;
+        for (const auto& lag: lags)
+        {
+            total += std::max<Offset>(lag.second.lag(), 0);
+        }
+        return total;
+    }
+
+    /**
+     * A snapshot of the lags (for all assigned partitions), taken at a time point.
+     */
+    struct LagSnapshot
+    {
+        std::chrono::system_clock::time_point timestamp;
+        LagTable                              lags;
+    };
+
+    /**
+     * A policy to prioritize the lagging partitions, -- returns the partitions (near the head) to be paused temporarily, thus the lagging ones could get the fetch bandwidth.
+     * Note: The partitions not returned would be resumed (if they were paused by the policy).
+     */
+    using PrioritizationPolicy = std::function<TopicPartitions(const LagTable& lags)>;
+
+    /**
+     * The default prioritization policy.
+     * While the largest lag is at least `minLagToPrioritize`, the partitions whose lags are within `headRatio` of the largest one would be paused,
+     *   -- until the lags even out (i.e, the largest lag falls below `minLagToPrioritize`).
+     * Note: The partitions with unknown lags would never be paused.
+     */
+    inline PrioritizationPolicy prioritizeLaggingPartitions(Offset minLagToPrioritize, double headRatio = 0.1)
+    {
+        return [minLagToPrioritize, headRatio](const LagTable& lags) {
+            Offset maxLag = -1;
+            for (const auto& lag: lags)
+            {
+                maxLag = std::max(maxLag, lag.second.lag());
+            }
+
+            TopicPartitions toPause;
+            if (maxLag < std::max<Offset>(minLagToPrioritize, 1)) return toPause;
+
+            for (const auto& lag: lags)
+            {
+                const Offset partitionLag = lag.second.lag();
+                if (partitionLag >= 0 && static_cast<double>(partitionLag) <= static_cast<double>(maxLag) * headRatio)
+                {
+                    toPause.emplace(lag.first);
+                }
+            }
+            return toPause;
+        };
+    }
 }
 
 
@@ -50,12 +141,40 @@ protected:
     // Default value for property "max.poll.records" (which is same with Java API)
     static const constexpr char* DEFAULT_MAX_POLL_RECORDS_VALUE = "500";
 
+    // Default value for property "max.poll.bytes" (no limit)
+    static const constexpr char* DEFAULT_MAX_POLL_BYTES_VALUE = "0";
+
+    // Default value for properties "commit.coalescing.interval.ms"/"commit.coalescing.max.offset.delta" (no coalescing)
+    static const constexpr char* DEFAULT_COMMIT_COALESCING_VALUE = "0";
+
+    // Default value for property "lag.snapshot.interval.ms" (no snapshot)
+    static const constexpr char* DEFAULT_LAG_SNAPSHOT_INTERVAL_VALUE = "0";
+
+    // Default values for properties "adaptive.max.poll.records.min" (disabled)/"adaptive.max.poll.records.target.interval.ms"
+    static const constexpr char* DEFAULT_ADAPTIVE_MAX_POLL_RECORDS_MIN_VALUE             = "0";
+    static const constexpr char* DEFAULT_ADAPTIVE_MAX_POLL_RECORDS_TARGET_INTERVAL_VALUE = "1000";
+
+    // Default value for properties "flow.control.high.watermark.records"/"flow.control.high.watermark.bytes" (no limit)
+    static const constexpr char* DEFAULT_FLOW_CONTROL_HIGH_WATERMARK_VALUE = "0";
+
     enum class OffsetCommitOption { Auto, Manual };
 
     // Constructor
     KafkaConsumer(const Properties& properties, KafkaConsumer::OffsetCommitOption offsetCommitOption)
-        : KafkaClient(ClientType::KafkaConsumer, properties, registerConfigCallbacks, {ConsumerConfig::MAX_POLL_RECORDS}),
-          _offsetCommitOption(offsetCommitOption)
+        : KafkaClient(ClientType::KafkaConsumer, properties, registerConfigCallbacks,
+                      {ConsumerConfig::MAX_POLL_RECORDS, ConsumerConfig::MAX_POLL_BYTES,
+                       ConsumerConfig::COMMIT_COALESCING_INTERVAL_MS, ConsumerConfig::COMMIT_COALESCING_MAX_OFFSET_DELTA,
+                       ConsumerConfig::LAG_SNAPSHOT_INTERVAL_MS,
+                       ConsumerConfig::ADAPTIVE_MAX_POLL_RECORDS_MIN, ConsumerConfig::ADAPTIVE_MAX_POLL_RECORDS_TARGET_INTERVAL_MS,
+                       ConsumerConfig::FLOW_CONTROL_HIGH_WATERMARK_RECORDS, ConsumerConfig::FLOW_CONTROL_LOW_WATERMARK_RECORDS,
+                       ConsumerConfig::FLOW_CONTROL_HIGH_WATERMARK_BYTES,   ConsumerConfig::FLOW_CONTROL_LOW_WATERMARK_BYTES}),
+          _offsetCommitOption(offsetCommitOption),
+          _commitCoalescer(createOffsetCommitCoalescer(properties)),
+          _maxPollBytes(parseNumberProperty(properties, ConsumerConfig::MAX_POLL_BYTES)),
+          _pollController(createAdaptivePollController(properties)),
+          _flowController(parseWatermarks(properties, ConsumerConfig::FLOW_CONTROL_HIGH_WATERMARK_RECORDS, ConsumerConfig::FLOW_CONTROL_LOW_WATERMARK_RECORDS),
+                          parseWatermarks(properties, ConsumerConfig::FLOW_CONTROL_HIGH_WATERMARK_BYTES,   ConsumerConfig::FLOW_CONTROL_LOW_WATERMARK_BYTES)),
+          _lagSnapshotInterval(parseNumberProperty(properties, ConsumerConfig::LAG_SNAPSHOT_INTERVAL_MS))
     {
         auto propStr = properties.toString();
         KAFKA_API_DO_LOG(LOG_INFO, "initializes with properties[%s]", propStr.c_str());
@@ -127,6 +246,16 @@ public:
      */
     void seek(const TopicPartition& tp, Offset o, std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_SEEK_TIMEOUT_MS));
 
+    /**
+     * Overrides the fetch offsets (for many partitions at once) that the consumer will use on the next poll(timeout).
+     * All partitions are seeked with one single request to librdkafka, and only the ones not ready yet (e.g, just assigned) would be retried.
+     * Throws KafkaException with errors:
+     *   - RD_KAFKA_RESP_ERR__TIMED_OUT:         Operation timed out
+     *   - RD_KAFKA_RESP_ERR__UNKNOWN_PARTITION: Invalid partition
+     *   - RD_KAFKA_RESP_ERR__STATE:             Invalid broker state
+     */
+    void seek(const TopicPartitionOffsets& tpos, std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_SEEK_TIMEOUT_MS));
+
     /**
      * Seek to the first offset for each of the given partitions.
      * This function evaluates lazily, seeking to the first offset in all partitions only when poll(long) or position(TopicPartition) are called.
@@ -158,21 +287,43 @@ public:
      */
     Offset position(const TopicPartition& tp) const;
 
+    /**
+     * Get the offsets of the next records that will be fetched (for all the given partitions at once).
+     * Note: The position would be `RD_KAFKA_OFFSET_INVALID`, for a partition which has not been fetched from yet.
+     * Throws KafkaException with errors:
+     *   - RD_KAFKA_RESP_ERR__INVALID_ARG:  Invalid partitions
+     */
+    TopicPartitionOffsets positions(const TopicPartitions& tps) const;
+
     /**
      * Get the first offset for the given partitions.
      * This method does not change the current consumer position of the partitions.
+     * Note: The partitions are grouped by leaders, and one ListOffsets request would be sent to each broker (in parallel).
      * Throws KafkaException with errors:
-     *   - RD_KAFKA_RESP_ERR__FAIL:  Generic failure
+     *   - RD_KAFKA_RESP_ERR__TIMED_OUT:           Not all offsets could be fetched in time.
+     *   - RD_KAFKA_RESP_ERR__UNKNOWN_PARTITION:   Unknown partition
+     *   - RD_KAFKA_RESP_ERR_LEADER_NOT_AVAILABLE: Unable to query leaders from the given partitions.
      */
-    std::map<TopicPartition, Offset> beginningOffsets(const TopicPartitions& tps) const { return getOffsets(tps, true); }
+    std::map<TopicPartition, Offset> beginningOffsets(const TopicPartitions& tps,
+                                                      std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_QUERY_TIMEOUT_MS)) const
+    {
+        return getOffsets(tps, true, timeout);
+    }
 
     /**
      * Get the last offset for the given partitions.  The last offset of a partition is the offset of the upcoming message, i.e. the offset of the last available message + 1.
      * This method does not change the current consumer position of the partitions.
+     * Note: The partitions are grouped by leaders, and one ListOffsets request would be sent to each broker (in parallel).
      * Throws KafkaException with errors:
-     *   - RD_KAFKA_RESP_ERR__FAIL:  Generic failure
+     *   - RD_KAFKA_RESP_ERR__TIMED_OUT:           Not all offsets could be fetched in time.
+     *   - RD_KAFKA_RESP_ERR__UNKNOWN_PARTITION:   Unknown partition
+     *   - RD_KAFKA_RESP_ERR_LEADER_NOT_AVAILABLE: Unable to query leaders from the given partitions.
      */
-    std::map<TopicPartition, Offset> endOffsets(const TopicPartitions& tps) const { return getOffsets(tps, false); }
+    std::map<TopicPartition, Offset> endOffsets(const TopicPartitions& tps,
+                                                std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_QUERY_TIMEOUT_MS)) const
+    {
+        return getOffsets(tps, false, timeout);
+    }
 
     /**
      * Get the offsets for the given partitions by time-point.
@@ -193,6 +344,15 @@ public:
      */
     Offset committed(const TopicPartition& tp);
 
+    /**
+     * Get the last committed offsets for the given partitions (whether the commit happened by this process or another), -- with one single OffsetFetch request.
+     * Note: The offset would be `RD_KAFKA_OFFSET_INVALID`, for a partition which has no committed offset.
+     * Throws KafkaException with errors:
+     *   - RD_KAFKA_RESP_ERR__TIMED_OUT:    Operation timed out
+     *   - RD_KAFKA_RESP_ERR__INVALID_ARG:  Invalid partitions
+     */
+    TopicPartitionOffsets committed(const TopicPartitions& tps, std::chrono::milliseconds timeout = std::chrono::milliseconds(DEFAULT_QUERY_TIMEOUT_MS));
+
     /**
      * Fetch data for the topics or partitions specified using one of the subscribe/assign APIs.
      * Returns the polled records.
@@ -209,11 +369,210 @@ public:
      */
     std::size_t poll(std::chrono::milliseconds timeout, std::vector<ConsumerRecord>& output);
 
+    /**
+     * Fetch data for the topics or partitions specified using one of the subscribe/assign APIs, -- lingering for a larger batch.
+     * It keeps fetching until at least `minRecords` records are accumulated (bounded by `max.poll.records`), or `maxWait` elapsed, -- whichever comes first.
+     * Returns the polled records.
+     * Note: 1) With the bytes budget (`max.poll.bytes`), it might return earlier, once the budget is used up.
+     *       2) Make sure the `ConsumerRecord` be destructed before the `KafkaConsumer.close()`.
+     */
+    std::vector<ConsumerRecord> poll(std::size_t minRecords, std::chrono::milliseconds maxWait);
+
+    /**
+     * Fetch data for the topics or partitions specified using one of the subscribe/assign APIs, -- lingering for a larger batch.
+     * Returns the number of polled records (which have been saved into parameter `output`).
+     */
+    std::size_t poll(std::size_t minRecords, std::chrono::milliseconds maxWait, std::vector<ConsumerRecord>& output);
+
+    /**
+     * Get a file descriptor, which would become readable once records (or events, e.g. rebalance) are available to be polled.
+     * Thus the consumer could be integrated with an event loop (e.g, epoll/select/asio), -- watch the fd, and call `drain()` while it's readable.
+     * Note: The fd is owned by the consumer (and would be closed by `close()`), never read or close it within the application.
+     */
+    int eventFd();
+
+    /**
+     * Fetch the records (which are already available) without blocking, and consume the notification on `eventFd()`.
+     * Returns the polled records.
+     * Note: If there're still more records (than `max.poll.records`) left in the queue, the `eventFd()` would keep readable.
+     */
+    std::vector<ConsumerRecord> drain();
+
+    /**
+     * Fetch the records (which are already available) without blocking, and consume the notification on `eventFd()`.
+     * Returns the number of polled records (which have been saved into parameter `output`).
+     */
+    std::size_t drain(std::vector<ConsumerRecord>& output);
+
+#ifdef KAFKA_API_ENABLE_COROUTINE
+    /**
+     * The awaitable for `nextBatch()`.
+     */
+    class BatchAwaiter
+    {
+    public:
+        BatchAwaiter(KafkaConsumer& consumer, ConsumerEventLoop& loop): _consumer(consumer), _loop(loop) {}
+
+        bool await_ready()
+        {
+            return _loop.stopped() || _consumer.drain(_records) > 0;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            _loop.wait(_consumer.eventFd(), [this]() { return _consumer.drain(_records) > 0; }, handle);
+        }
+
+        std::vector<ConsumerRecord> await_resume() { return std::move(_records); }
+
+    private:
+        KafkaConsumer&              _consumer;
+        ConsumerEventLoop&          _loop;
+        std::vector<ConsumerRecord> _records;
+    };
+
+    /**
+     * Fetch the next batch of records within a coroutine, -- `auto records = co_await consumer.nextBatch(loop);`.
+     * The coroutine would be suspended (without blocking the thread) until records are available, and then resumed by the `loop`.
+     * Note: 1) The offsets would be stored/committed the same way as `poll()`.
+     *       2) An empty batch would be returned once the `loop` is stopped.
+     */
+    BatchAwaiter nextBatch(ConsumerEventLoop& loop) { return BatchAwaiter(*this, loop); }
+
+    /**
+     * An asynchronous stream of records, -- `auto record = co_await stream.next();` (repeatedly, until nothing returned).
+     */
+    class RecordStream
+    {
+    public:
+        /**
+         * The awaitable for `next()`.
+         */
+        class NextAwaiter
+        {
+        public:
+            explicit NextAwaiter(RecordStream& stream): _stream(stream), _batch(stream._consumer, stream._loop) {}
+
+            bool await_ready()                                { return _stream.hasBuffered() || _batch.await_ready(); }
+            void await_suspend(std::coroutine_handle<> handle) { _batch.await_suspend(handle); }
+
+            Optional<ConsumerRecord> await_resume()
+            {
+                if (!_stream.hasBuffered())
+                {
+                    _stream._buffer = _batch.await_resume();
+                    _stream._index  = 0;
+                }
+
+                if (!_stream.hasBuffered()) return Optional<ConsumerRecord>();
+
+                return std::move(_stream._buffer[_stream._index++]);
+            }
+
+        private:
+            RecordStream& _stream;
+            BatchAwaiter  _batch;
+        };
+
+        RecordStream(KafkaConsumer& consumer, ConsumerEventLoop& loop): _consumer(consumer), _loop(loop) {}
+
+        /**
+         * Fetch the next record (or nothing, once the `loop` is stopped).
+         */
+        NextAwaiter next() { return NextAwaiter(*this); }
+
+    private:
+        bool hasBuffered() const { return _index < _buffer.size(); }
+
+        KafkaConsumer&              _consumer;
+        ConsumerEventLoop&          _loop;
+        std::vector<ConsumerRecord> _buffer;
+        std::size_t                 _index = 0;
+    };
+
+    /**
+     * Get an asynchronous stream of records (driven by the `loop`), which fetches a batch at a time and yields the records one by one.
+     * Note: Make sure the stream (with the buffered records) be destructed before the `KafkaConsumer.close()`.
+     */
+    RecordStream records(ConsumerEventLoop& loop) { return RecordStream(*this, loop); }
+#endif
+
+    /**
+     * Get the statistics of offset commits, -- how many commit requests were made, and how many OffsetCommit requests were actually sent.
+     * Note: The difference between them is the number of OffsetCommit requests saved by coalescing (see `ConsumerConfig::COMMIT_COALESCING_INTERVAL_MS`).
+     */
+    OffsetCommitCoalescer::Statistics commitStatistics() const { return _commitCoalescer.statistics(); }
+
+    /**
+     * Get the metrics of the adaptive batch size, -- the maximum number of records for the latest poll, and the observations it's based on.
+     * Note: Only make sense with the adaptive batch size enabled (see `ConsumerConfig::ADAPTIVE_MAX_POLL_RECORDS_MIN`).
+     */
+    AdaptivePollController::Metrics adaptivePollMetrics() const { return _pollController.metrics(); }
+
+    /**
+     * Release a record which had been returned by `poll()`, -- it's no longer in flight (e.g, processed by the downstream stage).
+     * A partition paused by the flow control would be resumed (within `poll()`), once the in-flight records/bytes fall below the low watermarks.
+     * Note: 1) It's thread-safe, -- thus could be called by the processing stage directly.
+     *       2) Only make sense with the flow control enabled (see `ConsumerConfig::FLOW_CONTROL_HIGH_WATERMARK_RECORDS`).
+     */
+    void release(const ConsumerRecord& record)
+    {
+        _flowController.release(TopicPartition(record.topic(), record.partition()), 1, recordBytes(record));
+    }
+
+    /**
+     * Release a number of records (with the total size of their keys and values) for a partition, -- e.g, after the records have been destroyed.
+     */
+    void release(const TopicPartition& tp, std::size_t numRecords, std::size_t numBytes) { _flowController.release(tp, numRecords, numBytes); }
+
+    /**
+     * Get the records/bytes in flight (polled, but not released yet) for a partition.
+     */
+    FlowController::InFlight inFlight(const TopicPartition& tp) const { return _flowController.inFlight(tp); }
+
+    /**
+     * Get the partitions paused by the flow control.
+     */
+    TopicPartitions pausedByFlowControl() const { return _flowController.paused(); }
+
+    /**
+     * Prioritize the lagging partitions with a policy (e.g, `Consumer::prioritizeLaggingPartitions()`), which would be evaluated (within `poll()`) with the lags at intervals.
+     * The partitions returned by the policy would be paused, while the others (paused by the policy before) would be resumed.
+     * Note: 1) The lags are calculated with the high watermarks cached locally, thus no request would be sent to brokers.
+     *       2) With a null policy, the prioritization is disabled, and the partitions paused by it would be resumed.
+     */
+    void setPrioritizationPolicy(Consumer::PrioritizationPolicy policy, std::chrono::milliseconds interval = std::chrono::milliseconds(DEFAULT_PRIORITIZATION_INTERVAL_MS));
+
+    /**
+     * Get the partitions paused by the prioritization policy.
+     */
+    TopicPartitions pausedByPrioritization() const { return _prioritizationPaused; }
+
+    /**
+     * Get the lags for all assigned partitions, -- calculated with the consumer's positions and the high watermarks cached locally (from the latest fetch responses).
+     * Note: 1) No request would be sent to brokers, thus it's cheap enough to be called frequently.
+     *       2) The lag of a partition is unknown (-1), until some records have been fetched from it.
+     * Throws KafkaException with errors:
+     *   - RD_KAFKA_RESP_ERR__INVALID_ARG: Invalid partitions
+     */
+    Consumer::LagTable lag() const;
+
+    /**
+     * Get the latest snapshot of the lags, which is taken periodically within `poll()` (see `ConsumerConfig::LAG_SNAPSHOT_INTERVAL_MS`).
+     * Note: It's thread-safe, and returns nullptr if no snapshot has been taken yet.
+     */
+    std::shared_ptr<const Consumer::LagSnapshot> lagSnapshot() const
+    {
+        std::lock_guard<std::mutex> lock(_lagSnapshotLock);
+        return _lagSnapshot;
+    }
+
     /**
      * Suspend fetching from the requested partitions. Future calls to poll() will not return any records from these partitions until they have been resumed using resume().
      * Note: 1) After pausing, the application still need to call `poll()` at regular intervals.
      *       2) This method does not affect partition subscription/assignment (i.e, pause fetching from partitions would not trigger a rebalance, since the consumer is still alive).
      *       3) If none of the provided partitions is assigned to this consumer, an exception would be thrown.
+     *       4) The partitions would be kept paused until `resume()` is called, -- the flow control, or the prioritization policy, would not resume them.
      * Throws KafkaException with error:
      *   - RD_KAFKA_RESP_ERR__INVALID_ARG: Invalid arguments
      */
@@ -244,11 +603,21 @@ protected:
 #if __cplusplus >= 201703L
     static constexpr int DEFAULT_QUERY_TIMEOUT_MS = 10000;
     static constexpr int DEFAULT_SEEK_TIMEOUT_MS  = 10000;
-    static constexpr int SEEK_RETRY_INTERVAL_MS   = 5000;
+    static constexpr int SEEK_RETRY_MIN_BACKOFF_MS = 1;
+    static constexpr int SEEK_RETRY_MAX_BACKOFF_MS = 100;
 #else
     enum { DEFAULT_QUERY_TIMEOUT_MS = 10000 };
     enum { DEFAULT_SEEK_TIMEOUT_MS  = 10000 };
-    enum { SEEK_RETRY_INTERVAL_MS   = 5000  };
+    enum { SEEK_RETRY_MIN_BACKOFF_MS = 1    };
+    enum { SEEK_RETRY_MAX_BACKOFF_MS = 100  };
+#endif
+
+#if __cplusplus >= 201703L
+    static constexpr int POLL_CONTROLLER_LAG_REFRESH_INTERVAL_MS = 100;
+    static constexpr int DEFAULT_PRIORITIZATION_INTERVAL_MS      = 1000;
+#else
+    enum { POLL_CONTROLLER_LAG_REFRESH_INTERVAL_MS = 100 };
+    enum { DEFAULT_PRIORITIZATION_INTERVAL_MS      = 1000 };
 #endif
 
     const OffsetCommitOption _offsetCommitOption;
@@ -256,6 +625,16 @@ protected:
     enum class CommitType { Sync, Async };
     void commit(const TopicPartitionOffsets& tpos, CommitType type);
 
+    // Send the pending (coalesced) offsets, -- if it's time to, or forced with `CommitType::Sync`
+    void commitStoredOffsetsIfNecessary(CommitType type);
+    // Send the coalesced offsets with one OffsetCommit request
+    virtual void commitCoalescedOffsets(const TopicPartitionOffsets& tpos, CommitType type) { commit(tpos, type); }
+
+    // Merge offsets of commit requests
+    OffsetCommitCoalescer _commitCoalescer;
+    // The offsets of records returned by polls (for KafkaManualCommitConsumer with commit-coalescing enabled)
+    TopicPartitionOffsets _consumedOffsets;
+
     void close();
 
     // Offset Commit Callback (for librdkafka)
@@ -265,14 +644,36 @@ protected:
     static Properties validateAndReformProperties(const Properties& origProperties);
 
 private:
-    void commitStoredOffsetsIfNecessary(CommitType type);
+    static OffsetCommitCoalescer createOffsetCommitCoalescer(const Properties& properties);
+    static AdaptivePollController createAdaptivePollController(const Properties& properties);
+    static FlowController::Watermarks parseWatermarks(const Properties& properties, const char* highKey, const char* lowKey);
+
+    // The size counted by the flow control
+    static std::size_t recordBytes(const ConsumerRecord& record) { return record.key().size() + record.value().size(); }
+    // Pause/resume partitions with the in-flight records
+    void applyFlowControl();
+    // Pause/resume partitions with the prioritization policy (if it's time to)
+    void prioritizePartitionsIfNecessary();
+    // Pause the partitions (chosen by the prioritization policy), and resume the others paused before
+    void updatePausedByPrioritization(const TopicPartitions& toPause);
+
+    // Decide the batch size for the coming poll
+    std::size_t maxPollRecordsForNextPoll();
+
+    void takeLagSnapshotIfNecessary();
+
     void storeOffsetsIfNecessary(const std::vector<ConsumerRecord>& records);
 
     void seekToBeginningOrEnd(const TopicPartitions& tps, bool toBeginning, std::chrono::milliseconds timeout);
-    std::map<TopicPartition, Offset> getOffsets(const TopicPartitions& tps, bool atBeginning) const;
+    std::map<TopicPartition, Offset> getOffsets(const TopicPartitions& tps, bool atBeginning, std::chrono::milliseconds timeout) const;
 
     // Internal interface for "assign"
     void _assign(const TopicPartitions& tps);
+    // Internal interfaces for incremental "assign"/"unassign" (with cooperative rebalance protocol)
+    void _incrementalAssign(const TopicPartitions& tps);
+    void _incrementalUnassign(const TopicPartitions& tps);
+    // Whether the consumer group is using the cooperative rebalance protocol (e.g, with "cooperative-sticky" assignor)
+    bool isCooperativeRebalance() const;
     // Internal interface for "assignment"
     TopicPartitions assignment(bool withQueryRequest) const;
 
@@ -280,20 +681,64 @@ private:
 
     unsigned int _maxPollRecords = 500; // Default value for batch-poll
 
+    // The bytes budget for each poll, -- the records beyond it would be kept for the next poll (disabled with 0)
+    const std::size_t          _maxPollBytes;
+    std::deque<ConsumerRecord> _pendingRecords;
+    std::size_t                _pendingBytes = 0;
+
+    // Fetch records (appended to `output`), -- returns false if the bytes budget has been used up
+    bool fetchMessages(int timeoutMs, std::size_t maxRecords, std::vector<ConsumerRecord>& output, std::size_t& outputBytes);
+    // Drop the records kept for the next poll (e.g, the partitions are revoked, or seeked)
+    void discardPendingRecords(const TopicPartitions& tps);
+
+    // The partitions paused (for whatever reason), -- their records kept for the next poll would be held back until they're resumed
+    TopicPartitions _pausedPartitions;
+
+    bool isPaused(const ConsumerRecord& record) const
+    {
+        return !_pausedPartitions.empty() && _pausedPartitions.count(TopicPartition(record.topic(), record.partition())) > 0;
+    }
+    // Number (and bytes) of the records kept for the next poll, -- excluding the ones held back for the paused partitions
+    std::size_t pendingRecordsToReturn(std::size_t& bytes) const;
+
+    // Adjust the batch size for each poll, -- disabled by default
+    AdaptivePollController                _pollController;
+    Offset                                _pollControllerLag = -1;
+    std::chrono::steady_clock::time_point _pollControllerLagUpdated;
+
+    // Pause/resume partitions with the in-flight records, -- disabled by default
+    FlowController _flowController;
+
+    // Pause partitions near the head (with the policy), to prioritize the lagging ones, -- disabled by default
+    Consumer::PrioritizationPolicy        _prioritizationPolicy;
+    std::chrono::milliseconds             _prioritizationInterval{DEFAULT_PRIORITIZATION_INTERVAL_MS};
+    std::chrono::steady_clock::time_point _lastPrioritization;
+    TopicPartitions                       _prioritizationPaused;
+
+    // The partitions paused by the user (with `pause()`), -- would never be resumed by the flow control, or the prioritization policy
+    TopicPartitions                       _userPaused;
+
     rd_kafka_queue_unique_ptr _rk_queue;
 
+    // Notify the event loop (through a pipe) once the message-fetching queue turns non-empty, -- created on demand with `eventFd()`
+    std::unique_ptr<IoEventNotifier> _ioEventNotifier;
+
     // Save assignment info (from "assign()" call or rebalance callback) locally, to accelerate seeking procedure
     TopicPartitions _assignment;
     // Assignment from user's input, -- by calling "assign()"
     TopicPartitions _userAssignment;
 
-    // The offsets to store (and commit later)
-    std::map<TopicPartition, Offset> _offsetsToStore;
+    // Take lag snapshots periodically (within `poll()`), -- disabled with a zero interval
+    const std::chrono::milliseconds              _lagSnapshotInterval;
+    std::chrono::steady_clock::time_point        _lastLagSnapshot;
+    mutable std::mutex                           _lagSnapshotLock;
+    std::shared_ptr<const Consumer::LagSnapshot> _lagSnapshot;
 
     // Register Callbacks for rd_kafka_conf_t
     static void registerConfigCallbacks(rd_kafka_conf_t* conf);
 
-    void pollMessages(int timeoutMs, std::vector<ConsumerRecord>& output);
+    // Poll records, -- with `minRecords` (> 0), it would keep fetching until so many records are accumulated (or timed out)
+    void pollMessages(int timeoutMs, std::vector<ConsumerRecord>& output, std::size_t minRecords = 0);
 
     enum class PauseOrResumeOperation { Pause, Resume };
     void pauseOrResumePartitions(const TopicPartitions& tps, PauseOrResumeOperation op);
@@ -326,6 +771,51 @@ KafkaConsumer::validateAndReformProperties(const Properties& origProperties)
         properties.put(ConsumerConfig::MAX_POLL_RECORDS, DEFAULT_MAX_POLL_RECORDS_VALUE);
     }
 
+    // If no "max.poll.bytes" configured, use a default value (i.e, no limit)
+    if (!properties.getProperty(ConsumerConfig::MAX_POLL_BYTES))
+    {
+        properties.put(ConsumerConfig::MAX_POLL_BYTES, DEFAULT_MAX_POLL_BYTES_VALUE);
+    }
+
+    // If no commit-coalescing configured, use default values (i.e, disabled)
+    for (const auto* key: {ConsumerConfig::COMMIT_COALESCING_INTERVAL_MS, ConsumerConfig::COMMIT_COALESCING_MAX_OFFSET_DELTA})
+    {
+        if (!properties.getProperty(key))
+        {
+            properties.put(key, DEFAULT_COMMIT_COALESCING_VALUE);
+        }
+    }
+
+    // If no "lag.snapshot.interval.ms" configured, use a default value (i.e, disabled)
+    if (!properties.getProperty(ConsumerConfig::LAG_SNAPSHOT_INTERVAL_MS))
+    {
+        properties.put(ConsumerConfig::LAG_SNAPSHOT_INTERVAL_MS, DEFAULT_LAG_SNAPSHOT_INTERVAL_VALUE);
+    }
+
+    // If no adaptive batch size configured, use default values (i.e, disabled)
+    if (!properties.getProperty(ConsumerConfig::ADAPTIVE_MAX_POLL_RECORDS_MIN))
+    {
+        properties.put(ConsumerConfig::ADAPTIVE_MAX_POLL_RECORDS_MIN, DEFAULT_ADAPTIVE_MAX_POLL_RECORDS_MIN_VALUE);
+    }
+    if (!properties.getProperty(ConsumerConfig::ADAPTIVE_MAX_POLL_RECORDS_TARGET_INTERVAL_MS))
+    {
+        properties.put(ConsumerConfig::ADAPTIVE_MAX_POLL_RECORDS_TARGET_INTERVAL_MS, DEFAULT_ADAPTIVE_MAX_POLL_RECORDS_TARGET_INTERVAL_VALUE);
+    }
+
+    // If no flow control configured, use default values (i.e, no limit); And the low watermarks are half of the high ones by default
+    for (const auto& keys: {std::make_pair(ConsumerConfig::FLOW_CONTROL_HIGH_WATERMARK_RECORDS, ConsumerConfig::FLOW_CONTROL_LOW_WATERMARK_RECORDS),
+                            std::make_pair(ConsumerConfig::FLOW_CONTROL_HIGH_WATERMARK_BYTES,   ConsumerConfig::FLOW_CONTROL_LOW_WATERMARK_BYTES)})
+    {
+        if (!properties.getProperty(keys.first))
+        {
+            properties.put(keys.first, DEFAULT_FLOW_CONTROL_HIGH_WATERMARK_VALUE);
+        }
+        if (!properties.getProperty(keys.second))
+        {
+            properties.put(keys.second, std::to_string(parseNumberProperty(properties, keys.first) / 2));
+        }
+    }
+
     // We want to customize the auto-commit behavior, with librdkafka's configuration disabled
     properties.put(ENABLE_AUTO_COMMIT,       "false");
     properties.put(AUTO_COMMIT_INTERVAL_MS,  "0");
@@ -333,6 +823,40 @@ KafkaConsumer::validateAndReformProperties(const Properties& origProperties)
     return properties;
 }
 
+inline OffsetCommitCoalescer
+KafkaConsumer::createOffsetCommitCoalescer(const Properties& properties)
+{
+    return OffsetCommitCoalescer(std::chrono::milliseconds(parseNumberProperty(properties, ConsumerConfig::COMMIT_COALESCING_INTERVAL_MS)),
+                                 parseNumberProperty(properties, ConsumerConfig::COMMIT_COALESCING_MAX_OFFSET_DELTA));
+}
+
+inline FlowController::Watermarks
+KafkaConsumer::parseWatermarks(const Properties& properties, const char* highKey, const char* lowKey)
+{
+    FlowController::Watermarks watermarks;
+    watermarks.high = parseNumberProperty(properties, highKey);
+    watermarks.low  = parseNumberProperty(properties, lowKey);
+
+    if (watermarks.high > 0 && watermarks.low >= watermarks.high)
+    {
+        KAFKA_THROW_WITH_MSG(RD_KAFKA_RESP_ERR__INVALID_ARG, std::string("Invalid ").append(lowKey).append("[").append(std::to_string(watermarks.low)).append("], which must be less than ").append(highKey));
+    }
+
+    return watermarks;
+}
+
+inline AdaptivePollController
+KafkaConsumer::createAdaptivePollController(const Properties& properties)
+{
+    const std::size_t maxPollRecords = parseNumberProperty(properties, ConsumerConfig::MAX_POLL_RECORDS);
+    const std::size_t minPollRecords = parseNumberProperty(properties, ConsumerConfig::ADAPTIVE_MAX_POLL_RECORDS_MIN);
+
+    // Disabled with the lower bound as 0
+    return AdaptivePollController((minPollRecords == 0) ? maxPollRecords : minPollRecords,
+                                  maxPollRecords,
+                                  std::chrono::milliseconds(parseNumberProperty(properties, ConsumerConfig::ADAPTIVE_MAX_POLL_RECORDS_TARGET_INTERVAL_MS)));
+}
+
 // Register Callbacks for rd_kafka_conf_t
 inline void
 KafkaConsumer::registerConfigCallbacks(rd_kafka_conf_t* conf)
@@ -347,9 +871,11 @@ KafkaConsumer::close()
 {
     _opened = false;
 
+    stopBrokerMetadataCache();
+
     try
     {
-        // Commit the offsets for these messages which had been polled last time (for KafkaAutoCommitConsumer)
+        // Commit the pending offsets (for KafkaAutoCommitConsumer, or the coalesced commits)
         commitStoredOffsetsIfNecessary(CommitType::Sync);
     }
     catch(const KafkaException& e)
@@ -357,8 +883,16 @@ KafkaConsumer::close()
         KAFKA_API_DO_LOG(LOG_ERR, "met error[%s] while closing", e.what());
     }
 
+    // The records kept for the next poll would never be returned
+    _pendingRecords.clear();
+    _pendingBytes = 0;
+    _pausedPartitions.clear();
+    _userPaused.clear();
+
     rd_kafka_consumer_close(getClientHandle());
 
+    _ioEventNotifier.reset();
+
     while (rd_kafka_outq_len(getClientHandle()))
     {
         rd_kafka_poll(getClientHandle(), KafkaClient::TIMEOUT_INFINITE);
@@ -432,11 +966,73 @@ KafkaConsumer::_assign(const TopicPartitions& tps)
     rd_kafka_resp_err_t err = rd_kafka_assign(getClientHandle(), (rk_tps->cnt > 0) ? rk_tps.get() : nullptr);
     KAFKA_THROW_IF_WITH_ERROR(err);
 
+    TopicPartitions unassigned;
+    std::set_difference(_assignment.cbegin(), _assignment.cend(), tps.cbegin(), tps.cend(), std::inserter(unassigned, unassigned.begin()));
+    discardPendingRecords(unassigned);
+    for (const auto& tp: unassigned)
+    {
+        _pausedPartitions.erase(tp);
+        _userPaused.erase(tp);
+    }
+
     _assignment = tps;
 
     KAFKA_API_DO_LOG(LOG_INFO, "assigned with TopicPartitions[%s]", tpsStr.c_str());
 }
 
+// Incremental assign (with cooperative rebalance protocol), -- internal interface
+inline void
+KafkaConsumer::_incrementalAssign(const TopicPartitions& tps)
+{
+    std::string tpsStr = toString(tps);
+    KAFKA_API_DO_LOG(LOG_INFO, "will incrementally assign with TopicPartitions[%s]", tpsStr.c_str());
+
+    auto rk_tps = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList(tps));
+
+    auto error = rd_kafka_error_unique_ptr(rd_kafka_incremental_assign(getClientHandle(), rk_tps.get()));
+    if (error)
+    {
+        KAFKA_THROW_WITH_MSG(rd_kafka_error_code(error.get()), rd_kafka_error_string(error.get()));
+    }
+
+    _assignment.insert(tps.cbegin(), tps.cend());
+
+    KAFKA_API_DO_LOG(LOG_INFO, "incrementally assigned with TopicPartitions[%s]", tpsStr.c_str());
+}
+
+// Incremental unassign (with cooperative rebalance protocol), -- internal interface
+inline void
+KafkaConsumer::_incrementalUnassign(const TopicPartitions& tps)
+{
+    std::string tpsStr = toString(tps);
+    KAFKA_API_DO_LOG(LOG_INFO, "will incrementally unassign with TopicPartitions[%s]", tpsStr.c_str());
+
+    auto rk_tps = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList(tps));
+
+    auto error = rd_kafka_error_unique_ptr(rd_kafka_incremental_unassign(getClientHandle(), rk_tps.get()));
+    if (error)
+    {
+        KAFKA_THROW_WITH_MSG(rd_kafka_error_code(error.get()), rd_kafka_error_string(error.get()));
+    }
+
+    for (const auto& tp: tps)
+    {
+        _assignment.erase(tp);
+        _pausedPartitions.erase(tp);
+        _userPaused.erase(tp);
+    }
+    discardPendingRecords(tps);
+
+    KAFKA_API_DO_LOG(LOG_INFO, "incrementally unassigned with TopicPartitions[%s]", tpsStr.c_str());
+}
+
+inline bool
+KafkaConsumer::isCooperativeRebalance() const
+{
+    const char* protocol = rd_kafka_rebalance_protocol(getClientHandle());
+    return protocol && std::string(protocol) == "COOPERATIVE";
+}
+
 // Assign for Topic/Partition level, -- external interface
 inline void
 KafkaConsumer::assign(const TopicPartitions& tps)
@@ -481,54 +1077,127 @@ KafkaConsumer::assignment() const
 inline void
 KafkaConsumer::seek(const TopicPartition& tp, Offset o, std::chrono::milliseconds timeout)
 {
-    std::string tpStr = toString(tp);
-    KAFKA_API_DO_LOG(LOG_INFO, "will seek with topic-partition[%s], offset[%d]", tpStr.c_str(), o);
+    seek(TopicPartitionOffsets{{tp, o}}, timeout);
+}
+
+inline void
+KafkaConsumer::seek(const TopicPartitionOffsets& tpos, std::chrono::milliseconds timeout)
+{
+    if (tpos.empty()) return;
+
+    std::string tposStr = toString(tpos);
+    KAFKA_API_DO_LOG(LOG_INFO, "will seek with topic-partition-offsets[%s]", tposStr.c_str());
+
+    // The records kept for the next poll are no longer valid
+    TopicPartitions seekedPartitions;
+    for (const auto& tpo: tpos) seekedPartitions.emplace(tpo.first);
+    discardPendingRecords(seekedPartitions);
 
-    auto rkt = rd_kafka_topic_unique_ptr(rd_kafka_topic_new(getClientHandle(), tp.first.c_str(), nullptr));
-    if (!rkt)
+    // Commit the pending offsets (requested before the seek) for these partitions, -- then the flushed offsets would not filter out the smaller ones after a rewind
+    try
+    {
+        auto seekedOffsets = _commitCoalescer.flush(seekedPartitions);
+        if (!seekedOffsets.empty()) commitCoalescedOffsets(seekedOffsets, CommitType::Sync);
+    }
+    catch (const KafkaException& e)
     {
-        KAFKA_THROW(rd_kafka_last_error());
+        KAFKA_API_DO_LOG(LOG_ERR, "failed to commit offsets before seeking! error[%s]", e.what());
     }
+    _commitCoalescer.discard(seekedPartitions);
 
     const auto end = std::chrono::steady_clock::now() + timeout;
+    auto backoff   = std::chrono::milliseconds(SEEK_RETRY_MIN_BACKOFF_MS);
 
-    rd_kafka_resp_err_t err = RD_KAFKA_RESP_ERR_NO_ERROR;
-    do
+    TopicPartitionOffsets toSeek = tpos;
+    for (;;)
     {
-        err = rd_kafka_seek(rkt.get(), tp.second, o, SEEK_RETRY_INTERVAL_MS);
-        if (err != RD_KAFKA_RESP_ERR__STATE && err != RD_KAFKA_RESP_ERR__TIMED_OUT && err != RD_KAFKA_RESP_ERR__OUTDATED)
+        auto rk_tpos = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList(toSeek));
+
+        // With a timeout (> 0), it waits for the results, and the error for each partition would be set within the list
+        const auto remaining = std::max(std::chrono::duration_cast<std::chrono::milliseconds>(end - std::chrono::steady_clock::now()),
+                                        std::chrono::milliseconds(1));
+        auto error = rd_kafka_error_unique_ptr(rd_kafka_seek_partitions(getClientHandle(), rk_tpos.get(), convertMsDurationToInt(remaining)));
+        if (error)
         {
-            break;
+            KAFKA_THROW_WITH_MSG(rd_kafka_error_code(error.get()), rd_kafka_error_string(error.get()));
         }
 
-        // If the "seek" was called just after "assign", there's a chance that the toppar's "fetch_state" (async setted) was not ready yes.
-        // If that's the case, we would retry again (normally, just after a very short while, the "seek" would succeed)
-        std::this_thread::yield();
-    } while (std::chrono::steady_clock::now() < end);
+        TopicPartitionOffsets toRetry;
+        rd_kafka_resp_err_t err = RD_KAFKA_RESP_ERR_NO_ERROR;
+        for (int i = 0; i < rk_tpos->cnt; ++i)
+        {
+            const rd_kafka_topic_partition_t& rk_tp = rk_tpos->elems[i];
+            if (rk_tp.err == RD_KAFKA_RESP_ERR_NO_ERROR) continue;
 
-    KAFKA_THROW_IF_WITH_ERROR(err);
+            err = rk_tp.err;
 
-    KAFKA_API_DO_LOG(LOG_INFO, "seeked with topic-partition[%s], offset[%d]", tpStr.c_str(), o);
-}
+            const TopicPartition tp(rk_tp.topic, rk_tp.partition);
+            // If the "seek" was called just after "assign", there's a chance that the toppar's "fetch_state" (async setted) was not ready yet.
+            // If that's the case, we would retry again (normally, just after a very short while, the "seek" would succeed)
+            if (err != RD_KAFKA_RESP_ERR__STATE && err != RD_KAFKA_RESP_ERR__TIMED_OUT && err != RD_KAFKA_RESP_ERR__OUTDATED)
+            {
+                KAFKA_THROW_WITH_MSG(err, "Failed to seek with topic-partition[" + toString(tp) + "]");
+            }
 
-inline void
-KafkaConsumer::seekToBeginningOrEnd(const TopicPartitions& tps, bool toBeginning, std::chrono::milliseconds timeout)
-{
-    for (const auto& tp: tps)
+            toRetry.emplace(tp, toSeek[tp]);
+        }
+
+        if (toRetry.empty()) break;
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= end)
+        {
+            KAFKA_THROW_WITH_MSG(err, "Failed to seek with topic-partition-offsets[" + toString(toRetry) + "]");
+        }
+
+        // Only retry the partitions which were not ready, -- with an exponential backoff (instead of spinning)
+        std::this_thread::sleep_for(std::min(backoff, std::chrono::duration_cast<std::chrono::milliseconds>(end - now)));
+        backoff = std::min(backoff * 2, std::chrono::milliseconds(SEEK_RETRY_MAX_BACKOFF_MS));
+
+        toSeek.swap(toRetry);
+    }
+
+    KAFKA_API_DO_LOG(LOG_INFO, "seeked with topic-partition-offsets[%s]", tposStr.c_str());
+}
+
+inline void
+KafkaConsumer::seekToBeginningOrEnd(const TopicPartitions& tps, bool toBeginning, std::chrono::milliseconds timeout)
+{
+    TopicPartitionOffsets tpos;
+    for (const auto& tp: tps)
     {
-        seek(tp, (toBeginning ? RD_KAFKA_OFFSET_BEGINNING : RD_KAFKA_OFFSET_END), timeout);
+        tpos.emplace(tp, (toBeginning ? RD_KAFKA_OFFSET_BEGINNING : RD_KAFKA_OFFSET_END));
     }
+
+    seek(tpos, timeout);
 }
 
 inline Offset
 KafkaConsumer::position(const TopicPartition& tp) const
 {
-    auto rk_tp = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList({tp}));
+    return positions({tp}).at(tp);
+}
 
-    rd_kafka_resp_err_t err = rd_kafka_position(getClientHandle(), rk_tp.get());
+inline TopicPartitionOffsets
+KafkaConsumer::positions(const TopicPartitions& tps) const
+{
+    if (tps.empty()) return TopicPartitionOffsets();
+
+    auto rk_tpos = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList(tps));
+
+    rd_kafka_resp_err_t err = rd_kafka_position(getClientHandle(), rk_tpos.get());
     KAFKA_THROW_IF_WITH_ERROR(err);
 
-    return rk_tp->elems[0].offset;
+    TopicPartitionOffsets tpos = getTopicPartitionOffsets(rk_tpos.get());
+
+    // The records kept for the next poll (beyond the bytes budget) have not been returned yet
+    for (const auto& record: _pendingRecords)
+    {
+        auto it = tpos.find(TopicPartition(record.topic(), record.partition()));
+        if (it != tpos.end() && record.offset() >= 0 && record.offset() < it->second) it->second = record.offset();
+    }
+
+    return tpos;
 }
 
 inline std::map<TopicPartition, Offset>
@@ -564,20 +1233,32 @@ KafkaConsumer::offsetsForTime(const TopicPartitions& tps,
 }
 
 inline std::map<TopicPartition, Offset>
-KafkaConsumer::getOffsets(const TopicPartitions& tps, bool atBeginning) const
+KafkaConsumer::getOffsets(const TopicPartitions& tps, bool atBeginning, std::chrono::milliseconds timeout) const
 {
-    std::map<TopicPartition, Offset> result;
+    if (tps.empty()) return TopicPartitionOffsets();
 
-    for (const auto& tp: tps)
+    auto rk_tpos = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList(tps));
+
+    for (int i = 0; i < rk_tpos->cnt; ++i)
     {
-        Offset beginning{}, end{};
-        rd_kafka_resp_err_t err = rd_kafka_query_watermark_offsets(getClientHandle(), tp.first.c_str(), tp.second, &beginning, &end, 0);
-        KAFKA_THROW_IF_WITH_ERROR(err);
+        // The logical offsets would be sent as the (special) timestamps within the ListOffsets requests, -- then overridden by the results
+        rk_tpos->elems[i].offset = (atBeginning ? RD_KAFKA_OFFSET_BEGINNING : RD_KAFKA_OFFSET_END);
+    }
+
+    // Partitions are grouped by leaders, and the ListOffsets requests (one for each broker) are sent in parallel
+    rd_kafka_resp_err_t err = rd_kafka_offsets_for_times(getClientHandle(), rk_tpos.get(), convertMsDurationToInt(timeout));
+    KAFKA_THROW_IF_WITH_ERROR(err);
 
-        result[tp] = (atBeginning ? beginning : end);
+    for (int i = 0; i < rk_tpos->cnt; ++i)
+    {
+        const rd_kafka_topic_partition_t& rk_tp = rk_tpos->elems[i];
+        if (rk_tp.err != RD_KAFKA_RESP_ERR_NO_ERROR)
+        {
+            KAFKA_THROW_WITH_MSG(rk_tp.err, "Failed to query offsets for topic-partition[" + toString(TopicPartition(rk_tp.topic, rk_tp.partition)) + "]");
+        }
     }
 
-    return result;
+    return getTopicPartitionOffsets(rk_tpos.get());
 }
 
 // Commit
@@ -600,26 +1281,41 @@ KafkaConsumer::commit(const TopicPartitionOffsets& tpos, CommitType type)
 inline Offset
 KafkaConsumer::committed(const TopicPartition& tp)
 {
-    auto rk_tps = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList({tp}));
+    return committed({tp}, std::chrono::milliseconds::max()).at(tp);
+}
+
+// Fetch committed offsets (for many partitions at once)
+inline TopicPartitionOffsets
+KafkaConsumer::committed(const TopicPartitions& tps, std::chrono::milliseconds timeout)
+{
+    if (tps.empty()) return TopicPartitionOffsets();
+
+    auto rk_tpos = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList(tps));
 
-    rd_kafka_resp_err_t err = rd_kafka_committed(getClientHandle(), rk_tps.get(), TIMEOUT_INFINITE);
+    rd_kafka_resp_err_t err = rd_kafka_committed(getClientHandle(), rk_tpos.get(), convertMsDurationToInt(timeout));
     KAFKA_THROW_IF_WITH_ERROR(err);
 
-    return rk_tps->elems[0].offset;
+    for (int i = 0; i < rk_tpos->cnt; ++i)
+    {
+        const rd_kafka_topic_partition_t& rk_tp = rk_tpos->elems[i];
+        if (rk_tp.err != RD_KAFKA_RESP_ERR_NO_ERROR)
+        {
+            KAFKA_THROW_WITH_MSG(rk_tp.err, "Failed to fetch committed offset for topic-partition[" + toString(TopicPartition(rk_tp.topic, rk_tp.partition)) + "]");
+        }
+    }
+
+    return getTopicPartitionOffsets(rk_tpos.get());
 }
 
 // Commit stored offsets
 inline void
 KafkaConsumer::commitStoredOffsetsIfNecessary(CommitType type)
 {
-    if (_offsetCommitOption == OffsetCommitOption::Auto && !_offsetsToStore.empty())
+    // A `Sync` commit would flush all pending offsets, no matter whether it's time to or not
+    const bool toCommit = (type == CommitType::Sync) ? !_commitCoalescer.empty() : _commitCoalescer.isDue();
+    if (toCommit)
     {
-        for (auto& o: _offsetsToStore)
-        {
-            ++o.second;
-        }
-        commit(_offsetsToStore, type);
-        _offsetsToStore.clear();
+        commitCoalescedOffsets(_commitCoalescer.flush(), type);
     }
 }
 
@@ -627,33 +1323,325 @@ KafkaConsumer::commitStoredOffsetsIfNecessary(CommitType type)
 inline void
 KafkaConsumer::storeOffsetsIfNecessary(const std::vector<ConsumerRecord>& records)
 {
+    if (records.empty()) return;
+
     if (_offsetCommitOption == OffsetCommitOption::Auto)
     {
+        // committed offset should be "current received record's offset" + 1
+        TopicPartitionOffsets tpos;
+        for (const auto& record: records)
+        {
+            tpos[TopicPartition(record.topic(), record.partition())] = record.offset() + 1;
+        }
+        _commitCoalescer.merge(tpos);
+    }
+    else if (_commitCoalescer.isEnabled())
+    {
+        // Keep them for `commitSync()/commitAsync()` (without specified offsets), which would be coalesced
         for (const auto& record: records)
         {
-            _offsetsToStore[TopicPartition(record.topic(), record.partition())] = record.offset();
+            _consumedOffsets[TopicPartition(record.topic(), record.partition())] = record.offset() + 1;
+        }
+    }
+
+    // With the bytes budget, librdkafka's "auto-store" is disabled (since the records kept for the next poll have not been returned yet)
+    //   -- thus store the offsets for `commitSync()/commitAsync()` (without specified offsets) here
+    if (_offsetCommitOption == OffsetCommitOption::Manual && _maxPollBytes > 0)
+    {
+        TopicPartitionOffsets tpos;
+        for (const auto& record: records)
+        {
+            if (record.offset() < 0) continue;
+
+            tpos[TopicPartition(record.topic(), record.partition())] = record.offset() + 1;
+        }
+        if (tpos.empty()) return;
+
+        auto rk_tpos = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList(tpos));
+        rd_kafka_resp_err_t err = rd_kafka_offsets_store(getClientHandle(), rk_tpos.get());
+        if (err != RD_KAFKA_RESP_ERR_NO_ERROR)
+        {
+            KAFKA_API_DO_LOG(LOG_ERR, "failed to store offsets, error[%s]", rd_kafka_err2str(err));
         }
     }
 }
 
 // Fetch messages (internally used)
 inline void
-KafkaConsumer::pollMessages(int timeoutMs, std::vector<ConsumerRecord>& output)
+KafkaConsumer::pollMessages(int timeoutMs, std::vector<ConsumerRecord>& output, std::size_t minRecords)
 {
-    // Commit the offsets for these messages which had been polled last time (for KafkaAutoCommitConsumer)
+    // Commit the offsets for these messages which had been polled before (for KafkaAutoCommitConsumer, or the coalesced commits)
     commitStoredOffsetsIfNecessary(CommitType::Async);
 
-    // Poll messages with librdkafka's API
-    rd_kafka_message_t *msgPtrArray[_maxPollRecords];
-    std::size_t msgReceived = rd_kafka_consume_batch_queue(_rk_queue.get(), timeoutMs, msgPtrArray, _maxPollRecords);
+    // Resume the partitions whose in-flight records have been released
+    applyFlowControl();
+
+    // Give the fetch bandwidth to the lagging partitions
+    prioritizePartitionsIfNecessary();
+
+    const std::size_t maxPollRecords = maxPollRecordsForNextPoll();
 
-    // Wrap messages with ConsumerRecord
     output.clear();
-    output.reserve(msgReceived);
-    std::for_each(msgPtrArray, msgPtrArray + msgReceived, [&output](rd_kafka_message_t* rkMsg) { output.emplace_back(rkMsg); });
+
+    std::size_t outputBytes = 0;
+    if (minRecords == 0)
+    {
+        fetchMessages(timeoutMs, maxPollRecords, output, outputBytes);
+    }
+    else
+    {
+        // Linger (with many fetches) until enough records are accumulated, or the deadline is reached
+        //   -- with an infinite timeout (i.e, negative), there's no deadline at all
+        const std::size_t lingerRecords = std::min(minRecords, maxPollRecords);
+        const bool        hasDeadline   = (timeoutMs >= 0);
+        const auto        deadline      = std::chrono::steady_clock::now() + std::chrono::milliseconds(hasDeadline ? timeoutMs : 0);
+
+        bool withinBudget = true;
+        while (withinBudget && output.size() < lingerRecords)
+        {
+            int fetchTimeoutMs = TIMEOUT_INFINITE;
+            if (hasDeadline)
+            {
+                const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                if (remaining.count() <= 0) break;
+
+                fetchTimeoutMs = convertMsDurationToInt(remaining);
+            }
+
+            withinBudget = fetchMessages(fetchTimeoutMs, lingerRecords - output.size(), output, outputBytes);
+        }
+
+        // Take whatever is available (without waiting), up to `max.poll.records`
+        if (withinBudget && output.size() < maxPollRecords)
+        {
+            fetchMessages(0, maxPollRecords - output.size(), output, outputBytes);
+        }
+    }
+
+    // The partition leaders might have changed, -- drop the cached metadata
+    if (isBrokerMetadataCached())
+    {
+        for (const auto& record: output)
+        {
+            if (isStaleMetadataError(static_cast<rd_kafka_resp_err_t>(record.error().value()))) invalidateBrokerMetadata(record.topic());
+        }
+    }
 
     // Store the offsets for all these polled messages (for KafkaAutoCommitConsumer)
     storeOffsetsIfNecessary(output);
+
+    takeLagSnapshotIfNecessary();
+
+    if (_pollController.isEnabled()) _pollController.afterPoll(output.size());
+
+    // Account the polled records as in-flight, and pause the partitions with too many
+    if (_flowController.isEnabled())
+    {
+        for (const auto& record: output)
+        {
+            if (record.error()) continue;
+
+            _flowController.acquire(TopicPartition(record.topic(), record.partition()), recordBytes(record));
+        }
+        applyFlowControl();
+    }
+}
+
+inline bool
+KafkaConsumer::fetchMessages(int timeoutMs, std::size_t maxRecords, std::vector<ConsumerRecord>& output, std::size_t& outputBytes)
+{
+    if (_maxPollBytes == 0)
+    {
+        // Poll messages with librdkafka's API
+        rd_kafka_message_t *msgPtrArray[_maxPollRecords];
+        std::size_t msgReceived = rd_kafka_consume_batch_queue(_rk_queue.get(), timeoutMs, msgPtrArray, maxRecords);
+
+        // Wrap messages with ConsumerRecord
+        output.reserve(output.size() + msgReceived);
+        std::for_each(msgPtrArray, msgPtrArray + msgReceived, [&output](rd_kafka_message_t* rkMsg) { output.emplace_back(rkMsg); });
+        return true;
+    }
+
+    // Fetch more from librdkafka's queue, unless the records kept by last poll are enough for this one
+    std::size_t pendingBytes = 0;
+    const std::size_t numPending = pendingRecordsToReturn(pendingBytes);
+    if (numPending < maxRecords && pendingBytes < _maxPollBytes)
+    {
+        rd_kafka_message_t *msgPtrArray[_maxPollRecords];
+        // No need to wait, if there're records kept already
+        std::size_t msgReceived = rd_kafka_consume_batch_queue(_rk_queue.get(), numPending == 0 ? timeoutMs : 0,
+                                                               msgPtrArray, maxRecords - numPending);
+
+        std::for_each(msgPtrArray, msgPtrArray + msgReceived, [this](rd_kafka_message_t* rkMsg) {
+                                                                  _pendingRecords.emplace_back(rkMsg);
+                                                                  _pendingBytes += recordBytes(_pendingRecords.back());
+                                                              });
+    }
+
+    std::size_t taken = 0;
+    for (auto it = _pendingRecords.begin(); it != _pendingRecords.end() && taken < maxRecords; )
+    {
+        // The records for the paused partitions would be held back, -- no matter whether they were kept before or after the pause
+        if (isPaused(*it))
+        {
+            ++it;
+            continue;
+        }
+
+        const std::size_t size = recordBytes(*it);
+        // At least one record would be returned, even if it's larger than the budget
+        if (!output.empty() && outputBytes + size > _maxPollBytes) return false;
+
+        outputBytes   += size;
+        _pendingBytes -= size;
+        output.emplace_back(std::move(*it));
+        it = _pendingRecords.erase(it);
+        ++taken;
+    }
+
+    return outputBytes < _maxPollBytes;
+}
+
+inline std::size_t
+KafkaConsumer::pendingRecordsToReturn(std::size_t& bytes) const
+{
+    if (_pausedPartitions.empty())
+    {
+        bytes = _pendingBytes;
+        return _pendingRecords.size();
+    }
+
+    std::size_t cnt = 0;
+    bytes = 0;
+    for (const auto& record: _pendingRecords)
+    {
+        if (isPaused(record)) continue;
+
+        ++cnt;
+        bytes += recordBytes(record);
+    }
+    return cnt;
+}
+
+inline void
+KafkaConsumer::discardPendingRecords(const TopicPartitions& tps)
+{
+    if (_pendingRecords.empty() || tps.empty()) return;
+
+    auto toDiscard = [&tps](const ConsumerRecord& record) { return tps.count(TopicPartition(record.topic(), record.partition())) > 0; };
+
+    for (const auto& record: _pendingRecords)
+    {
+        if (toDiscard(record)) _pendingBytes -= recordBytes(record);
+    }
+    _pendingRecords.erase(std::remove_if(_pendingRecords.begin(), _pendingRecords.end(), toDiscard), _pendingRecords.end());
+}
+
+inline void
+KafkaConsumer::applyFlowControl()
+{
+    if (!_flowController.isEnabled()) return;
+
+    FlowController::Decision decision = _flowController.update();
+
+    // The ones paused by the prioritization policy (or by the user) would be kept paused
+    for (const auto& tp: _prioritizationPaused) decision.toResume.erase(tp);
+    for (const auto& tp: _userPaused)           decision.toResume.erase(tp);
+
+    // Note: With librdkafka, the records (fetched but not polled yet) for a paused partition would be discarded, and fetched again after resumed
+    if (!decision.toPause.empty())  pauseOrResumePartitions(decision.toPause,  PauseOrResumeOperation::Pause);
+    if (!decision.toResume.empty()) pauseOrResumePartitions(decision.toResume, PauseOrResumeOperation::Resume);
+}
+
+inline void
+KafkaConsumer::setPrioritizationPolicy(Consumer::PrioritizationPolicy policy, std::chrono::milliseconds interval)
+{
+    _prioritizationPolicy   = std::move(policy);
+    _prioritizationInterval = interval;
+    _lastPrioritization     = std::chrono::steady_clock::time_point();
+
+    if (!_prioritizationPolicy) updatePausedByPrioritization(TopicPartitions());
+}
+
+inline void
+KafkaConsumer::prioritizePartitionsIfNecessary()
+{
+    if (!_prioritizationPolicy) return;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - _lastPrioritization < _prioritizationInterval) return;
+
+    _lastPrioritization = now;
+
+    TopicPartitions toPause;
+    try
+    {
+        toPause = _prioritizationPolicy(lag());
+    }
+    catch (const KafkaException& e)
+    {
+        KAFKA_API_DO_LOG(LOG_ERR, "failed to prioritize partitions, error[%s]", e.what());
+        return;
+    }
+
+    updatePausedByPrioritization(toPause);
+}
+
+inline void
+KafkaConsumer::updatePausedByPrioritization(const TopicPartitions& toPause)
+{
+    // The ones paused by the flow control would be left alone
+    const TopicPartitions pausedByFlowControl = _flowController.paused();
+
+    TopicPartitions pausing, resuming, paused;
+    for (const auto& tp: toPause)
+    {
+        if (_prioritizationPaused.count(tp))
+        {
+            paused.emplace(tp);
+        }
+        else if (_assignment.count(tp) && !pausedByFlowControl.count(tp))
+        {
+            pausing.emplace(tp);
+            paused.emplace(tp);
+        }
+    }
+    for (const auto& tp: _prioritizationPaused)
+    {
+        if (!toPause.count(tp) && !pausedByFlowControl.count(tp) && !_userPaused.count(tp)) resuming.emplace(tp);
+    }
+
+    if (!pausing.empty())  pauseOrResumePartitions(pausing,  PauseOrResumeOperation::Pause);
+    if (!resuming.empty()) pauseOrResumePartitions(resuming, PauseOrResumeOperation::Resume);
+
+    _prioritizationPaused.swap(paused);
+}
+
+inline std::size_t
+KafkaConsumer::maxPollRecordsForNextPoll()
+{
+    if (!_pollController.isEnabled()) return _maxPollRecords;
+
+    // The lag is calculated locally, but still not necessary to refresh it for every poll
+    const auto now = std::chrono::steady_clock::now();
+    if (now - _pollControllerLagUpdated >= std::chrono::milliseconds(POLL_CONTROLLER_LAG_REFRESH_INTERVAL_MS))
+    {
+        _pollControllerLagUpdated = now;
+
+        try
+        {
+            const Consumer::LagTable lags = lag();
+            // Unknown lag (e.g, nothing fetched yet) should not shrink the batch
+            const bool anyUnknown = std::any_of(lags.cbegin(), lags.cend(), [](const Consumer::LagTable::value_type& tpLag) { return tpLag.second.lag() < 0; });
+            _pollControllerLag = (lags.empty() || anyUnknown) ? -1 : Consumer::totalLag(lags);
+        }
+        catch (const KafkaException&)
+        {
+            _pollControllerLag = -1;
+        }
+    }
+
+    return _pollController.beforePoll(_pollControllerLag, now);
 }
 
 // Fetch messages (return via return value)
@@ -673,6 +1661,114 @@ KafkaConsumer::poll(std::chrono::milliseconds timeout, std::vector<ConsumerRecor
     return output.size();
 }
 
+// Fetch messages with linger (return via return value)
+inline std::vector<ConsumerRecord>
+KafkaConsumer::poll(std::size_t minRecords, std::chrono::milliseconds maxWait)
+{
+    std::vector<ConsumerRecord> result;
+    poll(minRecords, maxWait, result);
+    return result;
+}
+
+// Fetch messages with linger (return via input parameter)
+inline std::size_t
+KafkaConsumer::poll(std::size_t minRecords, std::chrono::milliseconds maxWait, std::vector<ConsumerRecord>& output)
+{
+    pollMessages(convertMsDurationToInt(maxWait), output, std::max<std::size_t>(minRecords, 1));
+    return output.size();
+}
+
+inline int
+KafkaConsumer::eventFd()
+{
+    if (!_ioEventNotifier)
+    {
+        _ioEventNotifier = std::make_unique<IoEventNotifier>(_rk_queue.get());
+
+        // The records might have been queued before the notification was enabled
+        std::size_t pendingBytes = 0;
+        if (rd_kafka_queue_length(_rk_queue.get()) > 0 || pendingRecordsToReturn(pendingBytes) > 0) _ioEventNotifier->notify();
+    }
+
+    return _ioEventNotifier->fd();
+}
+
+// Fetch available messages without blocking (return via return value)
+inline std::vector<ConsumerRecord>
+KafkaConsumer::drain()
+{
+    std::vector<ConsumerRecord> result;
+    drain(result);
+    return result;
+}
+
+// Fetch available messages without blocking (return via input parameter)
+inline std::size_t
+KafkaConsumer::drain(std::vector<ConsumerRecord>& output)
+{
+    // Must be cleared before serving the queue, -- otherwise a notification (for newly arrived records) might be lost
+    if (_ioEventNotifier) _ioEventNotifier->clear();
+
+    pollMessages(0, output);
+
+    // librdkafka would only notify while the queue turns from empty to non-empty, thus re-arm it for the remaining records (including the ones kept by the bytes budget)
+    std::size_t pendingBytes = 0;
+    if (_ioEventNotifier && (rd_kafka_queue_length(_rk_queue.get()) > 0 || pendingRecordsToReturn(pendingBytes) > 0)) _ioEventNotifier->notify();
+
+    return output.size();
+}
+
+// Lag (calculated locally)
+inline Consumer::LagTable
+KafkaConsumer::lag() const
+{
+    Consumer::LagTable lags;
+
+    // Positions for all partitions, -- with one call
+    for (const auto& tpo: positions(assignment(false)))
+    {
+        const TopicPartition& tp = tpo.first;
+
+        // The watermarks cached locally (no network request)
+        Offset low = RD_KAFKA_OFFSET_INVALID, high = RD_KAFKA_OFFSET_INVALID;
+        if (rd_kafka_get_watermark_offsets(getClientHandle(), tp.first.c_str(), tp.second, &low, &high) != RD_KAFKA_RESP_ERR_NO_ERROR)
+        {
+            high = RD_KAFKA_OFFSET_INVALID;
+        }
+
+        Consumer::PartitionLag& partitionLag = lags[tp];
+        partitionLag.position      = tpo.second;
+        partitionLag.highWatermark = high;
+    }
+
+    return lags;
+}
+
+inline void
+KafkaConsumer::takeLagSnapshotIfNecessary()
+{
+    if (_lagSnapshotInterval.count() == 0) return;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (_lagSnapshot && now - _lastLagSnapshot < _lagSnapshotInterval) return;
+
+    _lastLagSnapshot = now;
+
+    try
+    {
+        auto snapshot = std::make_shared<Consumer::LagSnapshot>();
+        snapshot->timestamp = std::chrono::system_clock::now();
+        snapshot->lags      = lag();
+
+        std::lock_guard<std::mutex> lock(_lagSnapshotLock);
+        _lagSnapshot = std::move(snapshot);
+    }
+    catch (const KafkaException& e)
+    {
+        KAFKA_API_DO_LOG(LOG_ERR, "failed to take lag snapshot, error[%s]", e.what());
+    }
+}
+
 inline void
 KafkaConsumer::pauseOrResumePartitions(const TopicPartitions& tps, PauseOrResumeOperation op)
 {
@@ -695,9 +1791,22 @@ KafkaConsumer::pauseOrResumePartitions(const TopicPartitions& tps, PauseOrResume
         {
             KAFKA_API_DO_LOG(LOG_INFO, "%sd topic-partition[%s-%d]", opString, rk_tp.topic, rk_tp.partition, rd_kafka_err2str(rk_tp.err));
             ++cnt;
+
+            if (op == PauseOrResumeOperation::Pause)
+            {
+                _pausedPartitions.emplace(rk_tp.topic, rk_tp.partition);
+            }
+            else
+            {
+                _pausedPartitions.erase(TopicPartition(rk_tp.topic, rk_tp.partition));
+            }
         }
     }
 
+    // The records held back (for the resumed partitions) are ready to return
+    std::size_t pendingBytes = 0;
+    if (op == PauseOrResumeOperation::Resume && _ioEventNotifier && pendingRecordsToReturn(pendingBytes) > 0) _ioEventNotifier->notify();
+
     if (cnt == 0 && op == PauseOrResumeOperation::Pause)
     {
         std::string errMsg = std::string("No partition could be ") + opString + std::string("d among TopicPartitions[") + toString(tps) + std::string("]");
@@ -709,6 +1818,11 @@ inline void
 KafkaConsumer::pause(const TopicPartitions& tps)
 {
     pauseOrResumePartitions(tps, PauseOrResumeOperation::Pause);
+
+    for (const auto& tp: tps)
+    {
+        if (_pausedPartitions.count(tp)) _userPaused.emplace(tp);
+    }
 }
 
 inline void
@@ -721,6 +1835,8 @@ inline void
 KafkaConsumer::resume(const TopicPartitions& tps)
 {
     pauseOrResumePartitions(tps, PauseOrResumeOperation::Resume);
+
+    for (const auto& tp: tps) _userPaused.erase(tp);
 }
 
 inline void
@@ -736,26 +1852,72 @@ KafkaConsumer::onRebalance(rd_kafka_resp_err_t err, rd_kafka_topic_partition_lis
     TopicPartitions tps = getTopicPartitions(rk_partitions);
     std::string tpsStr = toString(tps);
 
+    // With the cooperative protocol, only the delta (i.e, partitions to be added/removed) would be provided
+    const bool cooperative = isCooperativeRebalance();
+
     switch(err)
     {
         case RD_KAFKA_RESP_ERR__ASSIGN_PARTITIONS:
-            KAFKA_API_DO_LOG(LOG_INFO, "invoked re-balance callback for event[ASSIGN_PARTITIONS]. topic-partitions[%s]", tpsStr.c_str());
-
-            // Assign with a brand new full list
-            _assign(tps);
+            KAFKA_API_DO_LOG(LOG_INFO, "invoked re-balance callback for event[ASSIGN_PARTITIONS]. topic-partitions[%s], cooperative[%s]", tpsStr.c_str(), (cooperative ? "true" : "false"));
+
+            if (cooperative)
+            {
+                // Add the newly assigned partitions, -- the others keep being consumed
+                _incrementalAssign(tps);
+            }
+            else
+            {
+                // Assign with a brand new full list
+                _assign(tps);
+            }
             break;
 
         case RD_KAFKA_RESP_ERR__REVOKE_PARTITIONS:
-            KAFKA_API_DO_LOG(LOG_INFO, "invoked re-balance callback for event[REVOKE_PARTITIONS]. topic-partitions[%s]", tpsStr.c_str());
-
-            _offsetsToStore.clear();
+            KAFKA_API_DO_LOG(LOG_INFO, "invoked re-balance callback for event[REVOKE_PARTITIONS]. topic-partitions[%s], cooperative[%s]", tpsStr.c_str(), (cooperative ? "true" : "false"));
+
+            // Commit the pending offsets (for KafkaAutoCommitConsumer, or the coalesced commits) before losing these partitions
+            //   -- unless the partitions have already been lost (e.g, session timed out), which might be owned by other consumers now
+            if (!rd_kafka_assignment_lost(getClientHandle()))
+            {
+                try
+                {
+                    if (cooperative)
+                    {
+                        // Only the offsets for the revoked partitions, -- the others would be kept pending (to be coalesced further)
+                        //   Note: only the callbacks of the coalesced `commitAsync` requests (with no offset for the retained partitions) would be triggered with this commit
+                        auto revokedOffsets = _commitCoalescer.flush(tps);
+                        if (!revokedOffsets.empty()) commitCoalescedOffsets(revokedOffsets, CommitType::Sync);
+                    }
+                    else
+                    {
+                        commitStoredOffsetsIfNecessary(CommitType::Sync);
+                    }
+                }
+                catch (const KafkaException& e)
+                {
+                    KAFKA_API_DO_LOG(LOG_ERR, "failed to commit offsets while revoking partitions! error[%s]", e.what());
+                }
+            }
+            _commitCoalescer.discard(tps);
+            for (const auto& tp: tps) _consumedOffsets.erase(tp);
+            // The in-flight records for these partitions would no longer be tracked
+            _flowController.discard(tps);
+            for (const auto& tp: tps) _prioritizationPaused.erase(tp);
 
             // For "manual commit" cases, user must take all the responsibility to commit while necessary.
             //   -- thus, they must register a valid rebalance event listener and do the "commit things" properly.
 
-            // Revoke all previously assigned partitions.
-            // Normally, another "ASSIGN_PARTITIONS" event would be received later.
-            _assign(TopicPartitions()); // with null
+            if (cooperative)
+            {
+                // Only revoke these partitions
+                _incrementalUnassign(tps);
+            }
+            else
+            {
+                // Revoke all previously assigned partitions.
+                // Normally, another "ASSIGN_PARTITIONS" event would be received later.
+                _assign(TopicPartitions()); // with null
+            }
             break;
 
         default:
@@ -885,6 +2047,8 @@ public:
         _pollThread.reset(); // Join the polling thread (in case it's running)
         _pollable.reset();
 
+        stopBrokerMetadataCache();
+
         KafkaConsumer::close();
 
         rd_kafka_queue_t* queue = getCommitCbQueue();
@@ -904,6 +2068,7 @@ public:
     void commitSync(const ConsumerRecord& record);
     /**
      * Commit the specified offsets for the specified list of topics and partitions.
+     * Note: With the commit coalescing enabled, the offsets not larger than the flushed ones (e.g, to rewind) would be committed directly, -- right after the pending ones.
      */
     void commitSync(const TopicPartitionOffsets& tpos);
     /**
@@ -918,7 +2083,10 @@ public:
     void commitAsync(const ConsumerRecord& record, const Consumer::OffsetCommitCallback& cb = OffsetCommitCallback());
     /**
      * Commit the specified offsets for the specified list of topics and partitions to Kafka.
-     * Note: If a callback is provided, it's guaranteed to be triggered (before closing the consumer).
+     * Note: 1) If a callback is provided, it's guaranteed to be triggered (before closing the consumer).
+     *       2) With the commit coalescing enabled, the offsets not larger than the flushed ones (e.g, to rewind) would be committed directly, -- right after the pending ones.
+     *       3) With the commit coalescing enabled, the callback would be triggered once the offsets for all its partitions have been committed (e.g, some of them while being revoked),
+     *          -- with the first error met, or `__ASSIGNMENT_LOST` if some partitions were lost before their offsets got committed.
      */
     void commitAsync(const TopicPartitionOffsets& tpos, const Consumer::OffsetCommitCallback& cb = OffsetCommitCallback());
 
@@ -938,6 +2106,11 @@ private:
 
     rd_kafka_queue_unique_ptr _rk_commit_cb_queue;
 
+    // Merge the offsets into the pending ones, -- returns false if they should be committed directly (e.g, the coalescing is disabled, or not larger than the flushed ones)
+    bool coalesceOffsets(const TopicPartitionOffsets& tpos);
+
+    void commitCoalescedOffsets(const TopicPartitionOffsets& tpos, CommitType type) override;
+
     std::unique_ptr<Pollable>   _pollable;
     std::unique_ptr<PollThread> _pollThread;
 
@@ -954,16 +2127,43 @@ private:
         Properties properties = KafkaConsumer::validateAndReformProperties(origProperties);
 
         // Automatically store offset of last message provided to application
-        properties.put(ENABLE_AUTO_OFFSET_STORE, "true");
+        //   -- unless with the bytes budget, since some records fetched by librdkafka would be kept for the next poll (i.e, not provided yet)
+        properties.put(ENABLE_AUTO_OFFSET_STORE, (parseNumberProperty(properties, ConsumerConfig::MAX_POLL_BYTES) > 0) ? "false" : "true");
 
         return properties;
     }
 };
 
+inline bool
+KafkaManualCommitConsumer::coalesceOffsets(const TopicPartitionOffsets& tpos)
+{
+    if (!_commitCoalescer.isEnabled() || tpos.empty()) return false;
+
+    _commitCoalescer.merge(tpos);
+
+    // Not covered by the pending offsets, -- it's not larger than the flushed ones (which might be still in flight, or even fail)
+    return _commitCoalescer.covers(tpos);
+}
+
+inline void
+KafkaManualCommitConsumer::commitCoalescedOffsets(const TopicPartitionOffsets& tpos, CommitType type)
+{
+    auto rk_tpos = rd_kafka_topic_partition_list_unique_ptr(createRkTopicPartitionList(tpos));
+
+    // The callbacks for the coalesced requests (served by these offsets) would be triggered with the result of the merged one
+    auto* opaque = new OffsetCommitCallback(_commitCoalescer.takeCallbacks(tpos));
+
+    // With no queue specified, the commit would be synchronous (and the callback would be served within this call)
+    rd_kafka_queue_t* queue = (type == CommitType::Async) ? getCommitCbQueue() : nullptr;
+
+    rd_kafka_resp_err_t err = rd_kafka_commit_queue(getClientHandle(), rk_tpos.get(), queue, &KafkaConsumer::offsetCommitCallback, opaque);
+    KAFKA_THROW_IF_WITH_ERROR(err);
+}
+
 inline void
 KafkaManualCommitConsumer::commitSync()
 {
-    commit(TopicPartitionOffsets(), CommitType::Sync);
+    commitSync(TopicPartitionOffsets());
 }
 
 inline void
@@ -973,22 +2173,57 @@ KafkaManualCommitConsumer::commitSync(const ConsumerRecord& record)
     // committed offset should be "current-received-offset + 1"
     tpos[TopicPartition(record.topic(), record.partition())] = record.offset() + 1;
 
-    commit(tpos, CommitType::Sync);
+    commitSync(tpos);
 }
 
 inline void
 KafkaManualCommitConsumer::commitSync(const TopicPartitionOffsets& tpos)
 {
-    commit(tpos, CommitType::Sync);
+    // Without specified offsets, it means to commit offsets for all the records returned by polls (only kept with the coalescing enabled)
+    const TopicPartitionOffsets& offsets = tpos.empty() ? _consumedOffsets : tpos;
+
+    // Merged with the pending `commitAsync` requests, -- all would be sent with one OffsetCommit request
+    if (coalesceOffsets(offsets))
+    {
+        commitStoredOffsetsIfNecessary(CommitType::Sync);
+        return;
+    }
+
+    // The pending offsets (for the earlier requests) go first, -- then these ones would not be overridden
+    commitStoredOffsetsIfNecessary(CommitType::Sync);
+
+    commit(offsets, CommitType::Sync);
+
+    if (_commitCoalescer.isEnabled()) _commitCoalescer.markFlushed(offsets);
 }
 
 inline void
 KafkaManualCommitConsumer::commitAsync(const TopicPartitionOffsets& tpos, const OffsetCommitCallback& cb)
 {
-    auto rk_tpos = rd_kafka_topic_partition_list_unique_ptr(tpos.empty() ? nullptr : createRkTopicPartitionList(tpos));
+    // Without specified offsets, it means to commit offsets for all the records returned by polls (only kept with the coalescing enabled)
+    const TopicPartitionOffsets& offsets = tpos.empty() ? _consumedOffsets : tpos;
+
+    if (coalesceOffsets(offsets))
+    {
+        if (cb) _commitCoalescer.addCallback(offsets, cb);
+
+        // Would be sent later (by `poll()`), if it's not the time to
+        commitStoredOffsetsIfNecessary(CommitType::Async);
+        return;
+    }
+
+    // The pending offsets (for the earlier requests) go first, -- then these ones would not be overridden
+    if (!_commitCoalescer.empty())
+    {
+        commitCoalescedOffsets(_commitCoalescer.flush(), CommitType::Async);
+    }
+
+    auto rk_tpos = rd_kafka_topic_partition_list_unique_ptr(offsets.empty() ? nullptr : createRkTopicPartitionList(offsets));
 
     rd_kafka_resp_err_t err = rd_kafka_commit_queue(getClientHandle(), rk_tpos.get(), getCommitCbQueue(), &KafkaConsumer::offsetCommitCallback, new OffsetCommitCallback(cb));
     KAFKA_THROW_IF_WITH_ERROR(err);
+
+    if (_commitCoalescer.isEnabled()) _commitCoalescer.markFlushed(offsets);
 }
 
 inline void
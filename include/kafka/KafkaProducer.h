@@ -381,6 +381,12 @@ KafkaProducer::validateAndReformProperties(const Properties& origProperties)
 inline void
 KafkaProducer::deliveryCallback(rd_kafka_t* rk, const rd_kafka_message_t* rkmsg, void* /*opaque*/)
 {
+    // The partition leaders might have changed, -- drop the cached metadata
+    if (isStaleMetadataError(rkmsg->err) && rkmsg->rkt)
+    {
+        kafkaClient(rk).invalidateBrokerMetadata(rd_kafka_topic_name(rkmsg->rkt));
+    }
+
     if (auto* msgOpaque = static_cast<MsgOpaque*>(rkmsg->_private))
     {
         (*msgOpaque)(rk, rkmsg);
@@ -468,6 +474,8 @@ KafkaProducer::close(std::chrono::milliseconds timeout)
 {
     _opened = false;
 
+    stopBrokerMetadataCache();
+
     std::error_code ec = flush(timeout);
 
     std::string errMsg = ec.message();
@@ -515,6 +523,12 @@ public:
         _pollThread.reset(); // Join the polling thread (in case it's running)
         _pollable.reset();
 
+        // No delivery callback (which might invalidate the cached metadata) would be running now
+        stopBrokerMetadataCache();
+
+        _ioEventNotifier.reset();
+        _rk_main_queue.reset();
+
         return KafkaProducer::close(timeout);
     }
 
@@ -583,10 +597,56 @@ public:
         _pollable->poll(convertMsDurationToInt(timeout));
     }
 
+    /**
+     * Get a file descriptor, which would become readable once MessageDelivery callbacks are ready to be triggered.
+     * Thus the producer could be integrated with an event loop (e.g, epoll/select/asio), -- watch the fd, and call `drain()` while it's readable.
+     * Note: 1) The KafkaAsyncProducer MUST be constructed with option `EventsPollingOption::Manual`.
+     *       2) The fd is owned by the producer (and would be closed by `close()`), never read or close it within the application.
+     */
+    int eventFd()
+    {
+        assert(!_pollThread);
+
+        if (!_ioEventNotifier)
+        {
+            _rk_main_queue.reset(rd_kafka_queue_get_main(getClientHandle()));
+            _ioEventNotifier = std::make_unique<IoEventNotifier>(_rk_main_queue.get());
+
+            // The events might have been queued before the notification was enabled
+            if (rd_kafka_queue_length(_rk_main_queue.get()) > 0) _ioEventNotifier->notify();
+        }
+
+        return _ioEventNotifier->fd();
+    }
+
+    /**
+     * Call the MessageDelivery callbacks (which are ready) without blocking, and consume the notification on `eventFd()`.
+     * Returns the number of events served.
+     * Note: The KafkaAsyncProducer MUST be constructed with option `EventsPollingOption::Manual`.
+     */
+    std::size_t drain()
+    {
+        assert(!_pollThread);
+
+        // Must be cleared before serving the queue, -- otherwise a notification (for newly arrived events) might be lost
+        if (_ioEventNotifier) _ioEventNotifier->clear();
+
+        int served = rd_kafka_poll(getClientHandle(), 0);
+
+        // librdkafka would only notify while the queue turns from empty to non-empty, thus re-arm it for the remaining events
+        if (_ioEventNotifier && rd_kafka_queue_length(_rk_main_queue.get()) > 0) _ioEventNotifier->notify();
+
+        return static_cast<std::size_t>(served);
+    }
+
 private:
     std::unique_ptr<Pollable>   _pollable;
     std::unique_ptr<PollThread> _pollThread;
 
+    // The main queue (for MessageDelivery callbacks) and its notifier, -- created on demand with `eventFd()`
+    rd_kafka_queue_unique_ptr        _rk_main_queue;
+    std::unique_ptr<IoEventNotifier> _ioEventNotifier;
+
     static void pollCallbacks(KafkaAsyncProducer* producer, int timeoutMs)
     {
         rd_kafka_poll(producer->getClientHandle(), timeoutMs);
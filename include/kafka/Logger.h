@@ -48,12 +48,16 @@ private:
 
 using Logger = std::function<void(int, const char*, int, const char* msg)>;
 
-inline void DefaultLogger(int level, const char* /*filename*/, int /*lineno*/, const char* msg)
+inline const char* getLogLevelName(int level)
 {
-    const char levelNames[][10] = {"EMERG", "ALERT", "CRIT", "ERR", "WARNING", "NOTICE", "INFO", "DEBUG", "INVALID"};
+    static const char levelNames[][10] = {"EMERG", "ALERT", "CRIT", "ERR", "WARNING", "NOTICE", "INFO", "DEBUG", "INVALID"};
     constexpr int INVALID_LEVEL = sizeof(levelNames)/sizeof(levelNames[0]) - 1;
-    const char* levelName = level < INVALID_LEVEL ? levelNames[level] : levelNames[INVALID_LEVEL];
-    std::cout << "[" << Utility::getCurrentTime() << "]" << levelName << " " << msg;
+    return (level >= 0 && level < INVALID_LEVEL) ? levelNames[level] : levelNames[INVALID_LEVEL];
+}
+
+inline void DefaultLogger(int level, const char* /*filename*/, int /*lineno*/, const char* msg)
+{
+    std::cout << "[" << Utility::getCurrentTime() << "]" << getLogLevelName(level) << " " << msg;
     std::cout << std::endl;
 }
 
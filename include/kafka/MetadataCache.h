@@ -0,0 +1,199 @@
+#pragma once
+
+#include "kafka/Project.h"
+
+#include "kafka/BrokerMetadata.h"
+#include "kafka/Types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+namespace KAFKA_API {
+
+/**
+ * Caches the BrokerMetadata (per topic) for a time-to-live.
+ *  - Lookups are served with an immutable snapshot (loaded atomically, without taking any lock), while updates copy the snapshot and swap it in (RCU-style).
+ *  - Once an entry has lived for most of its TTL, the next lookup schedules an asynchronous refresh (with the `Fetcher`), thus the hot entries would never expire.
+ * Note: The refresh would be done with a background thread (only if a `Fetcher` is provided), which is joined by the destructor.
+ */
+class MetadataCache
+{
+public:
+    using Clock   = std::chrono::steady_clock;
+    using Fetcher = std::function<Optional<BrokerMetadata>(const Topic&, std::chrono::milliseconds)>;
+
+    explicit MetadataCache(std::chrono::milliseconds ttl, Fetcher fetcher = Fetcher())
+        : _ttl(ttl), _refreshAfter(ttl * REFRESH_AHEAD_PERCENT / 100), _fetcher(std::move(fetcher))
+    {
+        if (_fetcher) _refreshThread = std::thread(&MetadataCache::keepRefreshing, this);
+    }
+
+    ~MetadataCache()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_refreshLock);
+            _running = false;
+        }
+        _refreshCv.notify_one();
+
+        if (_refreshThread.joinable()) _refreshThread.join();
+    }
+
+    MetadataCache(const MetadataCache&) = delete;
+    MetadataCache& operator=(const MetadataCache&) = delete;
+
+    /**
+     * Get the cached metadata for a topic (or nullptr, if it's not cached, or has expired).
+     */
+    std::shared_ptr<const BrokerMetadata> get(const Topic& topic, Clock::time_point now = Clock::now());
+
+    /**
+     * Cache the metadata for a topic (fetched at `now`).
+     */
+    void put(const Topic& topic, BrokerMetadata metadata, Clock::time_point now = Clock::now());
+
+    /**
+     * Drop the cached metadata for a topic (e.g, the partition leaders have changed), -- thus the next lookup would miss.
+     */
+    void invalidate(const Topic& topic);
+
+    /**
+     * Number of topics cached (including the expired ones).
+     */
+    std::size_t size() const { return std::atomic_load(&_snapshot)->size(); }
+
+private:
+    // An entry would be refreshed (asynchronously) once it has lived for such a percentage of the TTL
+#if __cplusplus >= 201703L
+    static constexpr int REFRESH_AHEAD_PERCENT = 80;
+#else
+    enum { REFRESH_AHEAD_PERCENT = 80 };
+#endif
+
+    struct Entry
+    {
+        Entry(BrokerMetadata md, Clock::time_point t): metadata(std::move(md)), fetchedAt(t) {}
+
+        const BrokerMetadata           metadata;
+        const Clock::time_point        fetchedAt;
+        mutable std::atomic_bool       refreshScheduled = {false};
+    };
+
+    using Snapshot = std::map<Topic, std::shared_ptr<const Entry>>;
+
+    void scheduleRefresh(const Topic& topic);
+    void keepRefreshing();
+
+    const std::chrono::milliseconds _ttl;
+    const std::chrono::milliseconds _refreshAfter;
+    const Fetcher                   _fetcher;
+
+    // Always points to a valid snapshot, -- read with `std::atomic_load`, and replaced (with `_writeLock` held) by `std::atomic_store`
+    std::shared_ptr<const Snapshot> _snapshot = std::make_shared<const Snapshot>();
+    std::mutex                      _writeLock;
+
+    std::mutex              _refreshLock;
+    std::condition_variable _refreshCv;
+    std::deque<Topic>       _toRefresh;
+    bool                    _running = true;
+    std::thread             _refreshThread;
+};
+
+inline std::shared_ptr<const BrokerMetadata>
+MetadataCache::get(const Topic& topic, Clock::time_point now)
+{
+    const std::shared_ptr<const Snapshot> snapshot = std::atomic_load(&_snapshot);
+
+    auto it = snapshot->find(topic);
+    if (it == snapshot->end()) return nullptr;
+
+    const std::shared_ptr<const Entry>& entry = it->second;
+
+    const auto age = now - entry->fetchedAt;
+    if (age >= _ttl) return nullptr;
+
+    // Only the first lookup (after the entry turned old) schedules the refresh
+    if (_fetcher && age >= _refreshAfter && !entry->refreshScheduled.exchange(true))
+    {
+        scheduleRefresh(topic);
+    }
+
+    // Shares the ownership of the entry, -- thus it keeps valid even after being replaced in the cache
+    return std::shared_ptr<const BrokerMetadata>(entry, &entry->metadata);
+}
+
+inline void
+MetadataCache::put(const Topic& topic, BrokerMetadata metadata, Clock::time_point now)
+{
+    auto entry = std::make_shared<const Entry>(std::move(metadata), now);
+
+    std::lock_guard<std::mutex> lock(_writeLock);
+
+    auto snapshot = std::make_shared<Snapshot>(*std::atomic_load(&_snapshot));
+    (*snapshot)[topic] = std::move(entry);
+    std::atomic_store(&_snapshot, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+}
+
+inline void
+MetadataCache::invalidate(const Topic& topic)
+{
+    std::lock_guard<std::mutex> lock(_writeLock);
+
+    const std::shared_ptr<const Snapshot> current = std::atomic_load(&_snapshot);
+    if (!current->count(topic)) return;
+
+    auto snapshot = std::make_shared<Snapshot>(*current);
+    snapshot->erase(topic);
+    std::atomic_store(&_snapshot, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+}
+
+inline void
+MetadataCache::scheduleRefresh(const Topic& topic)
+{
+    {
+        std::lock_guard<std::mutex> lock(_refreshLock);
+        _toRefresh.emplace_back(topic);
+    }
+    _refreshCv.notify_one();
+}
+
+inline void
+MetadataCache::keepRefreshing()
+{
+    // No need to wait longer than the time left before the entry expires, -- the lookups would fetch it synchronously after that
+    const auto timeout = std::max(_ttl - _refreshAfter, std::chrono::milliseconds(1));
+
+    std::unique_lock<std::mutex> lock(_refreshLock);
+    for (;;)
+    {
+        _refreshCv.wait(lock, [this]() { return !_running || !_toRefresh.empty(); });
+        if (!_running) return;
+
+        const Topic topic = std::move(_toRefresh.front());
+        _toRefresh.pop_front();
+
+        lock.unlock();
+
+        // If it fails, the entry would expire (with the `refreshScheduled` flag kept), -- and be fetched by the next lookup
+        const auto fetchedAt = Clock::now();
+        if (auto metadata = _fetcher(topic, timeout))
+        {
+            put(topic, std::move(*metadata), fetchedAt);
+        }
+
+        lock.lock();
+    }
+}
+
+} // end of KAFKA_API
+
@@ -0,0 +1,383 @@
+#pragma once
+
+#include "kafka/Project.h"
+
+#include "kafka/Error.h"
+#include "kafka/Types.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+
+namespace KAFKA_API {
+
+/**
+ * Merges the offsets of many commit requests, so that they could be sent with one single OffsetCommit request.
+ * The pending offsets would be flushed once the interval elapsed, or the accumulated offsets delta reached the threshold.
+ * Note: With both `interval` and `maxOffsetDelta` as 0, the coalescing is disabled (i.e, every request would be flushed immediately).
+ */
+class OffsetCommitCoalescer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * The callback for a coalesced request, -- with the offsets committed by the OffsetCommit requests which served it, and the result.
+     */
+    using Callback = std::function<void(const TopicPartitionOffsets& committed, std::error_code ec)>;
+
+    /**
+     * The statistics for commit requests.
+     */
+    struct Statistics
+    {
+        /**
+         * Number of commit requests received.
+         */
+        std::uint64_t requested = 0;
+
+        /**
+         * Number of OffsetCommit requests sent.
+         */
+        std::uint64_t sent      = 0;
+
+        /**
+         * Number of OffsetCommit requests saved by coalescing.
+         */
+        std::uint64_t saved() const { return requested > sent ? requested - sent : 0; }
+    };
+
+    explicit OffsetCommitCoalescer(std::chrono::milliseconds interval = std::chrono::milliseconds(0), std::uint64_t maxOffsetDelta = 0)
+        : _interval(interval), _maxOffsetDelta(maxOffsetDelta), _lastFlush(Clock::now())
+    {
+    }
+
+    /**
+     * Whether the commit requests would be merged or not.
+     */
+    bool isEnabled() const { return _interval.count() > 0 || _maxOffsetDelta > 0; }
+
+    /**
+     * Merge the offsets (for one commit request) into the pending offsets.
+     * For each partition, only the largest offset would be kept.
+     */
+    void merge(const TopicPartitionOffsets& tpos);
+
+    /**
+     * Whether these offsets would be committed with the pending ones, -- i.e, no smaller than the offsets for these partitions.
+     */
+    bool covers(const TopicPartitionOffsets& tpos) const;
+
+    /**
+     * Record the offsets committed without being coalesced (e.g, smaller than the flushed ones), -- the later requests would be compared with these.
+     * Note: There should be nothing pending for these partitions (i.e, flushed before).
+     */
+    void markFlushed(const TopicPartitionOffsets& tpos);
+
+    /**
+     * Keep the callback for a merged request.
+     * It would be triggered once the pending offsets for all its partitions have been flushed (with one, or several OffsetCommit requests).
+     */
+    void addCallback(const TopicPartitionOffsets& tpos, Callback cb);
+
+    /**
+     * Take the callback for the OffsetCommit request with these flushed offsets, -- which serves the kept callbacks (for these partitions).
+     * Note: 1) A kept callback would be triggered with the last OffsetCommit request for its partitions, and with the first error met (if any).
+     *       2) The OffsetCommit requests for the partial flushes (i.e, `flush(tps)`) should have completed before the next flush.
+     */
+    Callback takeCallbacks(const TopicPartitionOffsets& flushed);
+
+    /**
+     * Whether there's no pending offset.
+     */
+    bool empty() const { return _pending.empty(); }
+
+    /**
+     * The pending offsets (which have not been flushed yet).
+     */
+    const TopicPartitionOffsets& pending() const { return _pending; }
+
+    /**
+     * Whether it's time to flush the pending offsets.
+     */
+    bool isDue(Clock::time_point now = Clock::now()) const;
+
+    /**
+     * Take all the pending offsets away (with one OffsetCommit request to send).
+     */
+    TopicPartitionOffsets flush(Clock::time_point now = Clock::now());
+
+    /**
+     * Take the pending offsets for these partitions only (e.g, before they're revoked incrementally), -- the others would be kept pending.
+     */
+    TopicPartitionOffsets flush(const TopicPartitions& tps);
+
+    /**
+     * Forget everything about these partitions (e.g, after they're revoked, or seeked).
+     * Note: The kept callbacks waiting for these partitions (i.e, the offsets would never be committed) would be triggered with error `__ASSIGNMENT_LOST`.
+     */
+    void discard(const TopicPartitions& tps);
+
+    /**
+     * Fetch the statistics.
+     */
+    const Statistics& statistics() const { return _statistics; }
+
+private:
+    const std::chrono::milliseconds _interval;
+    const std::uint64_t             _maxOffsetDelta;
+
+    // Drop the pending offsets delta contributed by the partition (e.g, flushed, or discarded)
+    void dropPendingDelta(const TopicPartition& tp);
+
+    // A kept callback, -- with the offsets (for the partitions) which have not been flushed yet
+    struct KeptCallback
+    {
+        TopicPartitionOffsets remaining;
+        TopicPartitionOffsets committed;
+        std::error_code       error;
+        Callback              cb;
+    };
+    std::list<std::shared_ptr<KeptCallback>> _callbacks;
+
+    Clock::time_point     _lastFlush;
+    std::uint64_t         _pendingDelta = 0;
+    TopicPartitionOffsets _pending;
+    std::map<TopicPartition, std::uint64_t> _pendingDeltas;
+    TopicPartitionOffsets _flushed;
+    Statistics            _statistics;
+};
+
+inline void
+OffsetCommitCoalescer::merge(const TopicPartitionOffsets& tpos)
+{
+    if (tpos.empty()) return;
+
+    ++_statistics.requested;
+
+    for (const auto& tpo: tpos)
+    {
+        const TopicPartition& tp = tpo.first;
+        const Offset          o  = tpo.second;
+
+        auto pendingIt = _pending.find(tp);
+        if (pendingIt != _pending.end())
+        {
+            if (o <= pendingIt->second) continue;
+
+            const auto delta = static_cast<std::uint64_t>(o - pendingIt->second);
+            _pendingDelta      += delta;
+            _pendingDeltas[tp] += delta;
+            pendingIt->second = o;
+            continue;
+        }
+
+        // Without coalescing, every request would be flushed (i.e, no need to compare with the flushed offsets)
+        auto flushedIt = isEnabled() ? _flushed.find(tp) : _flushed.end();
+        if (flushedIt != _flushed.end() && o <= flushedIt->second) continue;
+
+        const auto delta = (flushedIt != _flushed.end()) ? static_cast<std::uint64_t>(o - flushedIt->second) : 1;
+        _pendingDelta      += delta;
+        _pendingDeltas[tp]  = delta;
+        _pending.emplace(tp, o);
+    }
+}
+
+inline bool
+OffsetCommitCoalescer::covers(const TopicPartitionOffsets& tpos) const
+{
+    return std::all_of(tpos.cbegin(), tpos.cend(),
+                       [this](const TopicPartitionOffsets::value_type& tpo) {
+                           auto it = _pending.find(tpo.first);
+                           return it != _pending.end() && it->second >= tpo.second;
+                       });
+}
+
+inline void
+OffsetCommitCoalescer::markFlushed(const TopicPartitionOffsets& tpos)
+{
+    if (tpos.empty()) return;
+
+    ++_statistics.sent;
+
+    for (const auto& tpo: tpos)
+    {
+        _flushed[tpo.first] = tpo.second;
+    }
+}
+
+inline void
+OffsetCommitCoalescer::addCallback(const TopicPartitionOffsets& tpos, Callback cb)
+{
+    auto kept = std::make_shared<KeptCallback>();
+    kept->cb = std::move(cb);
+
+    // Only wait for the partitions with pending offsets
+    for (const auto& tpo: tpos)
+    {
+        if (_pending.count(tpo.first)) kept->remaining.emplace(tpo);
+    }
+    _callbacks.emplace_back(std::move(kept));
+}
+
+inline OffsetCommitCoalescer::Callback
+OffsetCommitCoalescer::takeCallbacks(const TopicPartitionOffsets& flushed)
+{
+    // The kept callbacks served by this flush, -- and whether it's the last flush for them
+    std::vector<std::pair<std::shared_ptr<KeptCallback>, bool>> served;
+
+    for (auto it = _callbacks.begin(); it != _callbacks.end();)
+    {
+        const auto& kept = *it;
+
+        bool isServed = false;
+        for (auto remainingIt = kept->remaining.begin(); remainingIt != kept->remaining.end();)
+        {
+            auto flushedIt = flushed.find(remainingIt->first);
+            if (flushedIt != flushed.end() && flushedIt->second >= remainingIt->second)
+            {
+                remainingIt = kept->remaining.erase(remainingIt);
+                isServed = true;
+            }
+            else
+            {
+                ++remainingIt;
+            }
+        }
+
+        if (!isServed)
+        {
+            ++it;
+            continue;
+        }
+
+        const bool isLast = kept->remaining.empty();
+        served.emplace_back(kept, isLast);
+        it = isLast ? _callbacks.erase(it) : std::next(it);
+    }
+
+    return [served](const TopicPartitionOffsets& committed, std::error_code ec) {
+               for (const auto& item: served)
+               {
+                   const auto& kept = item.first;
+                   for (const auto& tpo: committed)
+                   {
+                       kept->committed[tpo.first] = tpo.second;
+                   }
+                   if (ec && !kept->error) kept->error = ec;
+
+                   if (item.second && kept->cb) kept->cb(kept->committed, kept->error);
+               }
+           };
+}
+
+inline bool
+OffsetCommitCoalescer::isDue(Clock::time_point now) const
+{
+    if (_pending.empty()) return false;
+
+    if (!isEnabled()) return true;
+
+    if (_maxOffsetDelta > 0 && _pendingDelta >= _maxOffsetDelta) return true;
+
+    return _interval.count() > 0 && now - _lastFlush >= _interval;
+}
+
+inline TopicPartitionOffsets
+OffsetCommitCoalescer::flush(Clock::time_point now)
+{
+    _lastFlush = now;
+
+    if (_pending.empty()) return TopicPartitionOffsets();
+
+    ++_statistics.sent;
+
+    for (const auto& tpo: _pending)
+    {
+        _flushed[tpo.first] = tpo.second;
+    }
+
+    _pendingDelta = 0;
+    _pendingDeltas.clear();
+
+    TopicPartitionOffsets ret;
+    ret.swap(_pending);
+    return ret;
+}
+
+inline TopicPartitionOffsets
+OffsetCommitCoalescer::flush(const TopicPartitions& tps)
+{
+    TopicPartitionOffsets ret;
+    for (const auto& tp: tps)
+    {
+        auto it = _pending.find(tp);
+        if (it == _pending.end()) continue;
+
+        _flushed[tp] = it->second;
+        ret.emplace(*it);
+        _pending.erase(it);
+
+        // The delta threshold is only for the partitions which remain pending
+        dropPendingDelta(tp);
+    }
+
+    if (ret.empty()) return ret;
+
+    ++_statistics.sent;
+
+    return ret;
+}
+
+inline void
+OffsetCommitCoalescer::discard(const TopicPartitions& tps)
+{
+    for (const auto& tp: tps)
+    {
+        _pending.erase(tp);
+        _flushed.erase(tp);
+        dropPendingDelta(tp);
+    }
+
+    for (auto it = _callbacks.begin(); it != _callbacks.end();)
+    {
+        const auto kept = *it;
+
+        bool isLost = false;
+        for (const auto& tp: tps)
+        {
+            isLost = (kept->remaining.erase(tp) > 0) || isLost;
+        }
+        if (isLost && !kept->error) kept->error = ErrorCode(RD_KAFKA_RESP_ERR__ASSIGNMENT_LOST);
+
+        if (!kept->remaining.empty())
+        {
+            ++it;
+            continue;
+        }
+
+        it = _callbacks.erase(it);
+        if (kept->cb) kept->cb(kept->committed, kept->error);
+    }
+}
+
+inline void
+OffsetCommitCoalescer::dropPendingDelta(const TopicPartition& tp)
+{
+    auto it = _pendingDeltas.find(tp);
+    if (it == _pendingDeltas.end()) return;
+
+    _pendingDelta -= std::min(_pendingDelta, it->second);
+    _pendingDeltas.erase(it);
+}
+
+} // end of KAFKA_API
+
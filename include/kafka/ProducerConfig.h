@@ -133,6 +133,12 @@ public:
      * The client's Kerberos principal name.
      */
     static const constexpr char* SASL_KERBEROS_SERVICE_NAME   = "sasl.kerberos.service.name";
+
+    /**
+     * Cache the metadata (fetched with `fetchBrokerMetadata()`) for such a time-to-live, and refresh it in the background before it expires.
+     * Default value: 0 (no cache)
+     */
+    static const constexpr char* METADATA_CACHE_TTL_MS        = "metadata.cache.ttl.ms";
 };
 
 }
@@ -10,3 +10,10 @@
 // #define KAFKA_API_ENABLE_UNIT_TEST_STUBS
 // #endif
 
+// Coroutine-based interfaces (e.g, `KafkaConsumer::nextBatch()`) are only available with C++20 coroutines support
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define KAFKA_API_ENABLE_COROUTINE
+#endif
+#endif
+
@@ -39,6 +39,15 @@ using rd_kafka_NewTopic_unique_ptr = std::unique_ptr<rd_kafka_NewTopic_t, RkNewT
 struct RkDeleteTopicDeleter { void operator()(rd_kafka_DeleteTopic_t* p) { rd_kafka_DeleteTopic_destroy(p); } };
 using rd_kafka_DeleteTopic_unique_ptr = std::unique_ptr<rd_kafka_DeleteTopic_t, RkDeleteTopicDeleter>;
 
+struct RkNewPartitionsDeleter { void operator()(rd_kafka_NewPartitions_t* p) { rd_kafka_NewPartitions_destroy(p); } };
+using rd_kafka_NewPartitions_unique_ptr = std::unique_ptr<rd_kafka_NewPartitions_t, RkNewPartitionsDeleter>;
+
+struct RkErrorDeleter { void operator()(rd_kafka_error_t* p) { rd_kafka_error_destroy(p); } };
+using rd_kafka_error_unique_ptr = std::unique_ptr<rd_kafka_error_t, RkErrorDeleter>;
+
+struct RkAdminOptionsDeleter { void operator()(rd_kafka_AdminOptions_t* p) { rd_kafka_AdminOptions_destroy(p); } };
+using rd_kafka_AdminOptions_unique_ptr = std::unique_ptr<rd_kafka_AdminOptions_t, RkAdminOptionsDeleter>;
+
 
 // Convert from rd_kafka_xxx datatypes
 inline TopicPartitionOffsets getTopicPartitionOffsets(const rd_kafka_topic_partition_list_t* rk_tpos)
@@ -1,10 +1,16 @@
 #include "../utils/TestUtility.h"
 
 #include "kafka/AdminClient.h"
+#include "kafka/KafkaConsumer.h"
+#include "kafka/KafkaProducer.h"
 
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <future>
 #include <iostream>
+#include <set>
+#include <vector>
 
 using namespace KAFKA_API;
 
@@ -103,3 +109,282 @@ TEST(AdminClient, DuplicatedCreateDeleteTopics)
     }
 }
 
+TEST(AdminClient, FetchMetadataForMultipleTopics)
+{
+    const Topics topics = {Utility::getRandomString(), Utility::getRandomString(), Utility::getRandomString()};
+    const int numPartitions = 3;
+    const int replicaFactor = 1;
+
+    AdminClient adminClient(KafkaTestUtility::GetKafkaClientCommonConfig());
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " started" << std::endl;
+
+    auto createResult = adminClient.createTopics(topics, numPartitions, replicaFactor);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " topics created, result: " << createResult.detail << std::endl;
+    ASSERT_FALSE(createResult.error);
+
+    KafkaTestUtility::WaitMetadataSyncUpBetweenBrokers();
+
+    // All in one MetadataRequest
+    auto metadatas = adminClient.fetchBrokerMetadata(topics);
+    EXPECT_EQ(topics.size(), metadatas.size());
+    for (const auto& topic: topics)
+    {
+        ASSERT_EQ(1, metadatas.count(topic));
+        EXPECT_EQ(numPartitions, metadatas.at(topic).partitions().size());
+        std::cout << "[" << Utility::getCurrentTime() << "] BrokerMetadata: " << metadatas.at(topic).toString() << std::endl;
+    }
+
+    // List the topics with partition counts
+    auto listResult = adminClient.listTopics(topics);
+    EXPECT_FALSE(listResult.error);
+    EXPECT_EQ(topics, listResult.topics);
+    for (const auto& topic: topics)
+    {
+        EXPECT_EQ(numPartitions, listResult.numPartitions[topic]);
+    }
+
+    // The full list has the partition counts as well
+    auto fullListResult = adminClient.listTopics();
+    EXPECT_FALSE(fullListResult.error);
+    for (const auto& topic: topics)
+    {
+        EXPECT_EQ(numPartitions, fullListResult.numPartitions[topic]);
+    }
+
+    auto deleteResult = adminClient.deleteTopics(topics);
+    EXPECT_FALSE(deleteResult.error);
+}
+
+TEST(AdminClient, ConcurrentAsyncOperations)
+{
+    // Referred to by the callbacks, -- must outlive the AdminClient (whose destructor would abort the pending operations with the callbacks)
+    std::atomic<int> deleted(0);
+
+    AdminClient adminClient(KafkaTestUtility::GetKafkaClientCommonConfig());
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " started" << std::endl;
+
+    constexpr int NUM_TOPICS = 10;
+    std::vector<Topic> topics;
+    for (int i = 0; i < NUM_TOPICS; ++i) topics.emplace_back(Utility::getRandomString());
+
+    // All in flight at the same time
+    std::vector<std::future<Admin::CreateTopicsResult>> createResults;
+    for (const auto& topic: topics)
+    {
+        createResults.emplace_back(adminClient.createTopicsAsync({topic}, 3, 1));
+    }
+    for (auto& result: createResults)
+    {
+        auto createResult = result.get();
+        std::cout << "[" << Utility::getCurrentTime() << "] topic created, result: " << createResult.detail << std::endl;
+        EXPECT_FALSE(createResult.error);
+    }
+
+    KafkaTestUtility::WaitMetadataSyncUpBetweenBrokers();
+
+    // With callbacks
+    for (const auto& topic: topics)
+    {
+        adminClient.deleteTopicsAsync({topic}, std::chrono::seconds(30),
+                                      [&deleted](const Admin::DeleteTopicsResult& result) {
+                                          EXPECT_FALSE(result.error);
+                                          ++deleted;
+                                      });
+    }
+
+    KafkaTestUtility::WaitUntil([&deleted]() { return deleted == NUM_TOPICS; }, std::chrono::seconds(30));
+    EXPECT_EQ(NUM_TOPICS, deleted);
+}
+
+TEST(AdminClient, WaitForTopicsReady)
+{
+    AdminClient adminClient(KafkaTestUtility::GetKafkaClientCommonConfig());
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " started" << std::endl;
+
+    const Topics topics = {Utility::getRandomString(), Utility::getRandomString()};
+    const int numPartitions = 5;
+
+    auto createResult = adminClient.createTopicsAsync(topics, numPartitions, 1).get();
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " topics created, result: " << createResult.detail << std::endl;
+    ASSERT_FALSE(createResult.error);
+
+    auto readyResult = adminClient.waitForTopicsReady(topics, std::chrono::seconds(30));
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " topics ready, result: " << readyResult.detail << std::endl;
+    EXPECT_FALSE(readyResult.error);
+
+    // Every partition has a leader
+    for (const auto& topic: topics)
+    {
+        auto metadata = adminClient.fetchBrokerMetadata(topic);
+        ASSERT_TRUE(metadata);
+        EXPECT_EQ(numPartitions, metadata->partitions().size());
+    }
+
+    auto deleteResult = adminClient.deleteTopics(topics);
+    EXPECT_FALSE(deleteResult.error);
+}
+
+TEST(AdminClient, CreateTopicsWithPerTopicSpecs)
+{
+    AdminClient adminClient(KafkaTestUtility::GetKafkaClientCommonConfig());
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " started" << std::endl;
+
+    // More topics than a single request would take
+    constexpr int NUM_TOPICS = 150;
+    std::vector<Admin::NewTopicSpec> specs;
+    for (int i = 0; i < NUM_TOPICS; ++i)
+    {
+        specs.emplace_back(Utility::getRandomString(), 1 + i % 3, 1, Properties().put("retention.ms", std::to_string(3600000 + i)));
+    }
+
+    // An invalid one (rejected locally), and another one rejected by the brokers, -- would not fail the others
+    const Topic invalidTopic = Utility::getRandomString();
+    specs.emplace_back(invalidTopic, -2, 1);
+    const Topic invalidConfigTopic = Utility::getRandomString();
+    specs.emplace_back(invalidConfigTopic, 1, 1, Properties().put("no.such.config", "1"));
+    // A duplicated one (rejected locally), -- would not fail the others within the same request
+    const Topic duplicatedTopic = Utility::getRandomString();
+    specs.emplace_back(duplicatedTopic, 1, 1);
+    specs.emplace_back(duplicatedTopic, 2, 1);
+
+    auto createResult = adminClient.createTopics(specs, std::chrono::seconds(60));
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " topics created, result: " << createResult.detail << std::endl;
+    EXPECT_TRUE(createResult.error);
+    ASSERT_EQ(specs.size() - 1, createResult.topicResults.size());
+
+    Topics created;
+    for (int i = 0; i < NUM_TOPICS; ++i)
+    {
+        const auto& spec = specs[i];
+        EXPECT_FALSE(createResult.topicResults.at(spec.topic).error);
+        created.emplace(spec.topic);
+    }
+    EXPECT_EQ(RD_KAFKA_RESP_ERR__INVALID_ARG, createResult.topicResults.at(invalidTopic).error.value());
+    EXPECT_TRUE(createResult.topicResults.at(invalidConfigTopic).error);
+    EXPECT_NE(RD_KAFKA_RESP_ERR__INVALID_ARG, createResult.topicResults.at(invalidConfigTopic).error.value());
+    EXPECT_EQ(RD_KAFKA_RESP_ERR__INVALID_ARG, createResult.topicResults.at(duplicatedTopic).error.value());
+
+    // Check the partition counts
+    auto listResult = adminClient.listTopics(created);
+    EXPECT_FALSE(listResult.error);
+    for (int i = 0; i < NUM_TOPICS; ++i)
+    {
+        EXPECT_EQ(specs[i].numPartitions, listResult.numPartitions[specs[i].topic]);
+    }
+
+    auto deleteResult = adminClient.deleteTopics(created);
+    EXPECT_FALSE(deleteResult.error);
+}
+
+TEST(AdminClient, CreatePartitions)
+{
+    const Topic topic = Utility::getRandomString();
+    KafkaTestUtility::CreateKafkaTopic(topic, 2, 1);
+
+    AdminClient adminClient(KafkaTestUtility::GetKafkaClientCommonConfig());
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " started" << std::endl;
+
+    KafkaSyncProducer producer(KafkaTestUtility::GetKafkaClientCommonConfig());
+
+    // Partition 3 doesn't exist yet
+    const auto record = ProducerRecord(topic, 3, Key(nullptr, 0), Value(nullptr, 0));
+    EXPECT_KAFKA_THROW(producer.send(record), RD_KAFKA_RESP_ERR__UNKNOWN_PARTITION);
+
+    auto createResult = adminClient.createPartitions({{topic, 4}});
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " partitions created, result: " << createResult.detail << std::endl;
+    ASSERT_FALSE(createResult.error);
+
+    // Can't decrease the number of partitions
+    auto invalidResult = adminClient.createPartitions({{topic, 1}});
+    EXPECT_TRUE(invalidResult.error);
+
+    ASSERT_FALSE(adminClient.waitForTopicsReady({topic}).error);
+
+    // The producer would pick up the new partitions with the refreshed metadata
+    auto metadatas = producer.refreshBrokerMetadata({topic});
+    ASSERT_EQ(1, metadatas.count(topic));
+    EXPECT_EQ(4, metadatas.at(topic).partitions().size());
+
+    auto metadata = producer.send(record);
+    EXPECT_EQ(3, metadata.partition());
+}
+
+TEST(AdminClient, CreatePartitionsWithClientsToRefresh)
+{
+    const Topic topic = Utility::getRandomString();
+    KafkaTestUtility::CreateKafkaTopic(topic, 2, 1);
+
+    AdminClient adminClient(KafkaTestUtility::GetKafkaClientCommonConfig());
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " started" << std::endl;
+
+    KafkaSyncProducer producer(KafkaTestUtility::GetKafkaClientCommonConfig());
+
+    // Let the producer know the topic (with 2 partitions) before
+    auto brokerMetadata = producer.fetchBrokerMetadata(topic);
+    ASSERT_TRUE(brokerMetadata);
+    EXPECT_EQ(2, brokerMetadata->partitions().size());
+
+    // The producer's metadata would be refreshed within the call
+    auto createResult = adminClient.createPartitions({{topic, 4}}, {producer});
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " partitions created, result: " << createResult.detail << std::endl;
+    ASSERT_FALSE(createResult.error);
+
+    // Send to the new partition right after, -- no manual refresh
+    auto metadata = producer.send(ProducerRecord(topic, 3, Key(nullptr, 0), Value(nullptr, 0)));
+    EXPECT_EQ(3, metadata.partition());
+
+    // The partitioner would pick up the new partitions as well
+    std::set<Partition> partitions;
+    for (int i = 0; i < 100; ++i)
+    {
+        const std::string key = std::to_string(i);
+        partitions.emplace(producer.send(ProducerRecord(topic, Key(key.c_str(), key.size()), Value(nullptr, 0))).partition());
+    }
+    EXPECT_EQ(4, partitions.size());
+}
+
+TEST(AdminClient, DescribeConsumerGroupLags)
+{
+    const Topic     topic     = Utility::getRandomString();
+    const Partition partition = 0;
+    KafkaTestUtility::CreateKafkaTopic(topic, 1, 1);
+
+    // Prepare 10 messages
+    constexpr int NUM_MESSAGES = 10;
+    std::vector<std::tuple<Headers, std::string, std::string>> messages;
+    for (int i = 0; i < NUM_MESSAGES; ++i) messages.emplace_back(Headers{}, "", std::to_string(i));
+    KafkaTestUtility::ProduceMessages(topic, partition, messages);
+
+    // One group commits 4 records, and the other commits nothing
+    const std::string committedGroup = Utility::getRandomString();
+    const std::string idleGroup      = Utility::getRandomString();
+    {
+        KafkaManualCommitConsumer consumer(KafkaTestUtility::GetKafkaClientCommonConfig().put(ConsumerConfig::GROUP_ID, committedGroup));
+        consumer.assign({{topic, partition}});
+        consumer.commitSync({{{topic, partition}, 4}});
+    }
+
+    AdminClient adminClient(KafkaTestUtility::GetKafkaClientCommonConfig());
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " started" << std::endl;
+
+    const TopicPartition tp{topic, partition};
+
+    auto endOffsetsResult = adminClient.listEndOffsets({tp});
+    EXPECT_FALSE(endOffsetsResult.error);
+    EXPECT_EQ(NUM_MESSAGES, endOffsetsResult.offsets[tp]);
+    EXPECT_TRUE(endOffsetsResult.partitionErrors.empty());
+
+    auto lagsResult = adminClient.describeConsumerGroupLags({committedGroup, idleGroup}, {tp});
+    std::cout << "[" << Utility::getCurrentTime() << "] " << adminClient.name() << " lags described, result: " << lagsResult.detail << std::endl;
+    EXPECT_FALSE(lagsResult.error);
+
+    const auto& committedLag = lagsResult.groupLags[committedGroup][tp];
+    EXPECT_EQ(4, committedLag.committed);
+    EXPECT_EQ(NUM_MESSAGES, committedLag.endOffset);
+    EXPECT_EQ(NUM_MESSAGES - 4, committedLag.lag());
+    EXPECT_FALSE(committedLag.error);
+
+    // No offset committed, -- the lag is unknown
+    EXPECT_EQ(-1, lagsResult.groupLags[idleGroup][tp].lag());
+}
+
@@ -1,5 +1,6 @@
 #include "../utils/TestUtility.h"
 
+#include "kafka/EventTimeMerger.h"
 #include "kafka/KafkaConsumer.h"
 #include "kafka/KafkaProducer.h"
 
@@ -11,6 +12,7 @@
 #include <chrono>
 #include <cstring>
 #include <future>
+#include <poll.h>
 #include <thread>
 
 using namespace KAFKA_API;
@@ -82,6 +84,60 @@ TEST(KafkaAutoCommitConsumer, BasicPoll)
     consumer.close();
 }
 
+TEST(KafkaAutoCommitConsumer, DrainWithEventFd)
+{
+    const Topic     topic     = Utility::getRandomString();
+    const Partition partition = 0;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    // Prepare some messages to send
+    const std::vector<std::tuple<Headers, std::string, std::string>> messages = {
+        {Headers{}, "key1", "value1"},
+        {Headers{}, "key2", "value2"},
+        {Headers{}, "key3", "value3"},
+    };
+
+    // Send the messages
+    KafkaTestUtility::ProduceMessages(topic, partition, messages);
+
+    // With a small `max.poll.records`, the fd should keep readable until all records are drained
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ConsumerConfig::AUTO_OFFSET_RESET, "earliest")
+                       .put(ConsumerConfig::MAX_POLL_RECORDS,  "1");
+
+    KafkaAutoCommitConsumer consumer(props);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    struct pollfd pfd{consumer.eventFd(), POLLIN, 0};
+
+    consumer.subscribe({topic});
+
+    // Wait (with the event loop) for the records
+    std::vector<ConsumerRecord> records;
+    const auto end = std::chrono::steady_clock::now() + KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT;
+    while (records.size() < messages.size() && std::chrono::steady_clock::now() < end)
+    {
+        if (poll(&pfd, 1, static_cast<int>(KafkaTestUtility::POLL_INTERVAL.count())) <= 0) continue;
+
+        for (auto& record: consumer.drain())
+        {
+            EXPECT_FALSE(record.error());
+            records.emplace_back(std::move(record));
+        }
+    }
+
+    ASSERT_EQ(messages.size(), records.size());
+    for (std::size_t i = 0; i < messages.size(); ++i)
+    {
+        EXPECT_EQ(std::get<1>(messages[i]), records[i].key().toString());
+        EXPECT_EQ(std::get<2>(messages[i]), records[i].value().toString());
+    }
+
+    records.clear();
+    consumer.close();
+}
+
 TEST(KafkaAutoCommitConsumer, PollWithHeaders)
 {
     const Topic     topic     = Utility::getRandomString();
@@ -167,6 +223,33 @@ TEST(KafkaAutoCommitConsumer, PollWithHeaders)
             EXPECT_EQ(0, value.size());
         }
 
+        // The same headers, -- through the view (without copying)
+        const auto headersView = record.headersView();
+        ASSERT_EQ(expectedHeader.size(), headersView.size());
+        std::size_t idx = 0;
+        for (const auto header: headersView)
+        {
+            EXPECT_TRUE(header.keyEquals(expectedHeader[idx].key.c_str()));
+            EXPECT_EQ(expectedHeader[idx].value.toString(), header.value.toString());
+            ++idx;
+        }
+
+        // Lookup with the index
+        if (!headersView.empty())
+        {
+            const HeadersIndex<> index(headersView);
+            auto value = index.lastValue("k1");
+            ASSERT_EQ(sizeof(int), value.size());
+            EXPECT_EQ(0, std::memcmp(&v3, value.data(), value.size()));
+            EXPECT_EQ(v2, index.lastValue("k2").toString());
+            EXPECT_EQ(0, index.lastValue("nonexist").size());
+
+            // Only 1 header indexed, -- the others would be looked up through the view
+            const HeadersIndex<1> smallIndex(headersView);
+            EXPECT_EQ(value.data(), smallIndex.lastValue("k1").data());
+            EXPECT_EQ(v2, smallIndex.lastValue("k2").toString());
+        }
+
         ++rcvMsgCount;
     }
 
@@ -283,6 +366,622 @@ TEST(KafkaAutoCommitConsumer, SeekAndPoll)
     consumer.close();
 }
 
+TEST(KafkaAutoCommitConsumer, SeekManyPartitionsBenchmark)
+{
+    for (const int numPartitions: {1, 64, 512})
+    {
+        const Topic topic = Utility::getRandomString();
+        std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+        KafkaTestUtility::CreateKafkaTopic(topic, numPartitions, 1);
+
+        TopicPartitions tps;
+        for (Partition partition = 0; partition < numPartitions; ++partition)
+        {
+            tps.emplace(topic, partition);
+        }
+
+        // 2 messages for each partition, -- thus the seek (to offset 1) could be verified with the first record polled
+        {
+            KafkaSyncProducer producer(KafkaTestUtility::GetKafkaClientCommonConfig());
+            for (const auto& tp: tps)
+            {
+                for (int i = 0; i < 2; ++i)
+                {
+                    producer.send(ProducerRecord(topic, tp.second, NullKey, Value("value", 5)));
+                }
+            }
+        }
+
+        const Offset offsetToSeek = 1;
+
+        // Seek with a new consumer each time, -- just after the assignment (the partitions' fetch state might not be ready yet)
+        auto seekAndVerify = [&tps, offsetToSeek](bool batched) {
+            KafkaAutoCommitConsumer consumer(KafkaTestUtility::GetKafkaClientCommonConfig());
+            consumer.assign(tps);
+
+            const auto start = std::chrono::steady_clock::now();
+            if (batched)
+            {
+                TopicPartitionOffsets tpos;
+                for (const auto& tp: tps) tpos.emplace(tp, offsetToSeek);
+                consumer.seek(tpos);
+            }
+            else
+            {
+                for (const auto& tp: tps) consumer.seek(tp, offsetToSeek);
+            }
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+            // Every partition would start from the offset seeked to
+            std::map<TopicPartition, Offset> firstOffsets;
+            const auto end = std::chrono::steady_clock::now() + KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT;
+            while (firstOffsets.size() < tps.size() && std::chrono::steady_clock::now() < end)
+            {
+                for (const auto& record: consumer.poll(KafkaTestUtility::POLL_INTERVAL))
+                {
+                    if (record.error()) continue;
+
+                    firstOffsets.emplace(TopicPartition(record.topic(), record.partition()), record.offset());
+                }
+            }
+
+            EXPECT_EQ(tps.size(), firstOffsets.size());
+            for (const auto& tpo: firstOffsets)
+            {
+                EXPECT_EQ(offsetToSeek, tpo.second) << toString(tpo.first);
+            }
+
+            consumer.close();
+            return elapsed;
+        };
+
+        const auto batched  = seekAndVerify(true);
+        const auto oneByOne = seekAndVerify(false);
+
+        std::cout << "[" << Utility::getCurrentTime() << "] seek " << numPartitions << " partitions, batched: " << batched.count()
+                  << " ms, one by one: " << oneByOne.count() << " ms" << std::endl;
+    }
+}
+
+TEST(KafkaAutoCommitConsumer, BeginningAndEndOffsetsOfManyPartitions)
+{
+    const Topic topic         = Utility::getRandomString();
+    const int   numPartitions = 256;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    KafkaTestUtility::CreateKafkaTopic(topic, numPartitions, 3);
+
+    // Only send messages to partition 0
+    const std::vector<std::tuple<Headers, std::string, std::string>> messages = {
+        {Headers{}, "key1", "value1"},
+        {Headers{}, "key2", "value2"},
+        {Headers{}, "key3", "value3"},
+    };
+    KafkaTestUtility::ProduceMessages(topic, 0, messages);
+
+    KafkaAutoCommitConsumer consumer(KafkaTestUtility::GetKafkaClientCommonConfig());
+
+    TopicPartitions tps;
+    for (Partition partition = 0; partition < numPartitions; ++partition)
+    {
+        tps.emplace(topic, partition);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto beginningOffsets = consumer.beginningOffsets(tps, std::chrono::seconds(10));
+    const auto endOffsets       = consumer.endOffsets(tps, std::chrono::seconds(10));
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "[" << Utility::getCurrentTime() << "] queried offsets for " << numPartitions << " partitions in " << elapsed.count() << " ms" << std::endl;
+
+    ASSERT_EQ(tps.size(), beginningOffsets.size());
+    ASSERT_EQ(tps.size(), endOffsets.size());
+    for (const auto& tp: tps)
+    {
+        EXPECT_EQ(0, beginningOffsets.at(tp));
+        EXPECT_EQ((tp.second == 0 ? static_cast<Offset>(messages.size()) : 0), endOffsets.at(tp));
+    }
+
+    consumer.close();
+}
+
+TEST(KafkaAutoCommitConsumer, LagFromCachedWatermarks)
+{
+    const Topic     topic     = Utility::getRandomString();
+    const Partition partition = 0;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    // Prepare some messages to send
+    const std::vector<std::tuple<Headers, std::string, std::string>> messages = {
+        {Headers{}, "key1", "value1"},
+        {Headers{}, "key2", "value2"},
+        {Headers{}, "key3", "value3"},
+        {Headers{}, "key4", "value4"},
+        {Headers{}, "key5", "value5"},
+    };
+    KafkaTestUtility::ProduceMessages(topic, partition, messages);
+
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ConsumerConfig::AUTO_OFFSET_RESET,        "earliest")
+                       .put(ConsumerConfig::MAX_POLL_RECORDS,         "2")
+                       .put(ConsumerConfig::LAG_SNAPSHOT_INTERVAL_MS, "1");
+
+    KafkaAutoCommitConsumer consumer(props);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    consumer.subscribe({topic});
+
+    // Nothing fetched yet
+    EXPECT_EQ(nullptr, consumer.lagSnapshot());
+
+    // Poll for the first batch
+    std::size_t numConsumed = 0;
+    const auto end = std::chrono::steady_clock::now() + KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT;
+    while (numConsumed == 0 && std::chrono::steady_clock::now() < end)
+    {
+        numConsumed = consumer.poll(KafkaTestUtility::POLL_INTERVAL).size();
+    }
+    ASSERT_EQ(2, numConsumed);
+
+    const TopicPartition tp{topic, partition};
+
+    auto lags = consumer.lag();
+    std::cout << "[" << Utility::getCurrentTime() << "] position[" << lags[tp].position << "], high watermark[" << lags[tp].highWatermark << "]" << std::endl;
+    EXPECT_EQ(2, lags[tp].position);
+    EXPECT_EQ(static_cast<Offset>(messages.size()), lags[tp].highWatermark);
+    EXPECT_EQ(static_cast<Offset>(messages.size() - numConsumed), lags[tp].lag());
+    EXPECT_EQ(lags[tp].lag(), Consumer::totalLag(lags));
+
+    // The snapshot would be taken within the next poll
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    numConsumed += consumer.poll(KafkaTestUtility::POLL_INTERVAL).size();
+
+    auto snapshot = consumer.lagSnapshot();
+    ASSERT_NE(nullptr, snapshot);
+    EXPECT_EQ(static_cast<Offset>(messages.size() - numConsumed), snapshot->lags.at(tp).lag());
+
+    consumer.close();
+}
+
+TEST(KafkaAutoCommitConsumer, AdaptiveMaxPollRecords)
+{
+    const Topic     topic     = Utility::getRandomString();
+    const Partition partition = 0;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    // Prepare some messages to send
+    std::vector<std::tuple<Headers, std::string, std::string>> messages;
+    for (std::size_t i = 0; i < 2000; ++i)
+    {
+        messages.emplace_back(Headers{}, std::to_string(i), "value" + std::to_string(i));
+    }
+    KafkaTestUtility::ProduceMessages(topic, partition, messages);
+
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ConsumerConfig::AUTO_OFFSET_RESET,             "earliest")
+                       .put(ConsumerConfig::MAX_POLL_RECORDS,              "500")
+                       .put(ConsumerConfig::ADAPTIVE_MAX_POLL_RECORDS_MIN, "5");
+
+    KafkaAutoCommitConsumer consumer(props);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    consumer.subscribe({topic});
+
+    // Poll all messages
+    std::size_t numConsumed = 0;
+    const auto end = std::chrono::steady_clock::now() + KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT;
+    while (numConsumed < messages.size() && std::chrono::steady_clock::now() < end)
+    {
+        const auto records = consumer.poll(KafkaTestUtility::POLL_INTERVAL);
+        EXPECT_LE(records.size(), 500);
+        numConsumed += records.size();
+    }
+    EXPECT_EQ(messages.size(), numConsumed);
+
+    const auto metrics = consumer.adaptivePollMetrics();
+    std::cout << "[" << Utility::getCurrentTime() << "] max.poll.records[" << metrics.maxPollRecords << "], processing time per record[" << metrics.recordProcessingTimeUs
+              << "us], lag[" << metrics.lag << "], increases[" << metrics.increases << "], decreases[" << metrics.decreases << "]" << std::endl;
+
+    // Caught up, -- the batch would shrink to the lower bound (once the lag is refreshed)
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_TRUE(consumer.poll(KafkaTestUtility::POLL_INTERVAL).empty());
+    EXPECT_EQ(0, consumer.adaptivePollMetrics().lag);
+    EXPECT_EQ(5, consumer.adaptivePollMetrics().maxPollRecords);
+
+    consumer.close();
+}
+
+TEST(KafkaAutoCommitConsumer, FlowControlWithInFlightRecords)
+{
+    const Topic     topic     = Utility::getRandomString();
+    const Partition partition = 0;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    // Prepare some messages to send
+    std::vector<std::tuple<Headers, std::string, std::string>> messages;
+    for (std::size_t i = 0; i < 10; ++i)
+    {
+        messages.emplace_back(Headers{}, "key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    KafkaTestUtility::ProduceMessages(topic, partition, messages);
+
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ConsumerConfig::AUTO_OFFSET_RESET,                   "earliest")
+                       .put(ConsumerConfig::MAX_POLL_RECORDS,                    "2")
+                       .put(ConsumerConfig::FLOW_CONTROL_HIGH_WATERMARK_RECORDS, "3")
+                       .put(ConsumerConfig::FLOW_CONTROL_LOW_WATERMARK_RECORDS,  "1");
+
+    KafkaAutoCommitConsumer consumer(props);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    consumer.subscribe({topic});
+
+    const TopicPartition tp{topic, partition};
+
+    // Nothing released, -- the partition would be paused once 3 records are in flight
+    std::vector<ConsumerRecord> inFlight;
+    const auto end = std::chrono::steady_clock::now() + KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        for (auto& record: consumer.poll(KafkaTestUtility::POLL_INTERVAL))
+        {
+            inFlight.emplace_back(std::move(record));
+        }
+    }
+    std::cout << "[" << Utility::getCurrentTime() << "] " << inFlight.size() << " records in flight" << std::endl;
+
+    EXPECT_EQ(4, inFlight.size());
+    EXPECT_EQ(4, consumer.inFlight(tp).records);
+    EXPECT_EQ(TopicPartitions({tp}), consumer.pausedByFlowControl());
+
+    // Release them all, -- the partition would be resumed (within next poll), and the remaining records would be fetched
+    std::size_t numConsumed = inFlight.size();
+    for (const auto& record: inFlight)
+    {
+        consumer.release(record);
+    }
+    inFlight.clear();
+
+    const auto resumeEnd = std::chrono::steady_clock::now() + KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT;
+    while (numConsumed < messages.size() && std::chrono::steady_clock::now() < resumeEnd)
+    {
+        for (const auto& record: consumer.poll(KafkaTestUtility::POLL_INTERVAL))
+        {
+            ++numConsumed;
+            consumer.release(record);
+        }
+    }
+    EXPECT_EQ(messages.size(), numConsumed);
+    EXPECT_TRUE(consumer.pausedByFlowControl().empty());
+
+    consumer.close();
+}
+
+TEST(KafkaManualCommitConsumer, MaxPollBytes)
+{
+    const Topic     topic     = Utility::getRandomString();
+    const Partition partition = 0;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    // Prepare some messages to send, -- with a large one in the middle
+    std::vector<std::tuple<Headers, std::string, std::string>> messages;
+    for (std::size_t i = 0; i < 10; ++i)
+    {
+        messages.emplace_back(Headers{}, "", std::string((i == 5) ? 5000 : 1000, 'v'));
+    }
+    KafkaTestUtility::ProduceMessages(topic, partition, messages);
+
+    const std::size_t maxPollBytes = 2500;
+
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ConsumerConfig::AUTO_OFFSET_RESET, "earliest")
+                       .put(ConsumerConfig::MAX_POLL_BYTES,    std::to_string(maxPollBytes));
+
+    KafkaManualCommitConsumer consumer(props);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    consumer.subscribe({topic});
+
+    // Poll all messages, -- none of them would be lost (or duplicated), though some might be kept for the next poll
+    Offset expectedOffset = 0;
+    const auto end = std::chrono::steady_clock::now() + KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT;
+    while (expectedOffset < static_cast<Offset>(messages.size()) && std::chrono::steady_clock::now() < end)
+    {
+        const auto records = consumer.poll(KafkaTestUtility::POLL_INTERVAL);
+
+        std::size_t bytes = 0;
+        for (const auto& record: records)
+        {
+            EXPECT_EQ(expectedOffset++, record.offset());
+            bytes += record.value().size();
+        }
+
+        // The large one would be returned alone
+        if (records.size() > 1)
+        {
+            EXPECT_LE(bytes, maxPollBytes);
+        }
+
+        if (!records.empty())
+        {
+            std::cout << "[" << Utility::getCurrentTime() << "] polled " << records.size() << " records, with " << bytes << " bytes" << std::endl;
+
+            // Only the offsets for the returned records would be committed
+            consumer.commitSync();
+            EXPECT_EQ(expectedOffset, consumer.committed({topic, partition}));
+            EXPECT_EQ(expectedOffset, consumer.position({topic, partition}));
+        }
+    }
+    EXPECT_EQ(static_cast<Offset>(messages.size()), expectedOffset);
+
+    consumer.close();
+}
+
+TEST(KafkaManualCommitConsumer, PauseWithMaxPollBytes)
+{
+    const Topic     topic     = Utility::getRandomString();
+    const Partition partition = 0;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    std::vector<std::tuple<Headers, std::string, std::string>> messages;
+    for (std::size_t i = 0; i < 10; ++i)
+    {
+        messages.emplace_back(Headers{}, "", std::string(1000, 'v'));
+    }
+    KafkaTestUtility::ProduceMessages(topic, partition, messages);
+
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ConsumerConfig::AUTO_OFFSET_RESET, "earliest")
+                       .put(ConsumerConfig::MAX_POLL_BYTES,    "2500");
+
+    KafkaManualCommitConsumer consumer(props);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    const TopicPartition tp{topic, partition};
+    consumer.assign({tp});
+
+    // Poll until some records are returned, -- the others (beyond the bytes budget) would be kept for the next poll
+    Offset expectedOffset = 0;
+    const auto end = std::chrono::steady_clock::now() + KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT;
+    while (expectedOffset == 0 && std::chrono::steady_clock::now() < end)
+    {
+        for (const auto& record: consumer.poll(KafkaTestUtility::POLL_INTERVAL))
+        {
+            EXPECT_EQ(expectedOffset++, record.offset());
+        }
+    }
+    ASSERT_GT(expectedOffset, 0);
+    ASSERT_LT(expectedOffset, static_cast<Offset>(messages.size()));
+
+    // Nothing would be returned for the paused partition, -- including the records kept already
+    consumer.pause({tp});
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_TRUE(consumer.poll(KafkaTestUtility::POLL_INTERVAL).empty());
+    }
+    EXPECT_EQ(expectedOffset, consumer.position(tp));
+
+    // Continue from where it was paused, -- nothing lost or duplicated
+    consumer.resume({tp});
+    while (expectedOffset < static_cast<Offset>(messages.size()) && std::chrono::steady_clock::now() < end)
+    {
+        for (const auto& record: consumer.poll(KafkaTestUtility::POLL_INTERVAL))
+        {
+            EXPECT_EQ(expectedOffset++, record.offset());
+        }
+    }
+    EXPECT_EQ(static_cast<Offset>(messages.size()), expectedOffset);
+
+    consumer.close();
+}
+
+TEST(KafkaAutoCommitConsumer, PollWithLinger)
+{
+    const Topic     topic     = Utility::getRandomString();
+    const Partition partition = 0;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ConsumerConfig::AUTO_OFFSET_RESET, "earliest")
+                       .put(ConsumerConfig::MAX_POLL_RECORDS,  "8");
+
+    KafkaAutoCommitConsumer consumer(props);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    consumer.subscribe({topic});
+
+    // Send the messages one by one (with intervals), during the time the consumer is lingering
+    auto fut = std::async(std::launch::async,
+                          [topic, partition]() {
+                              for (std::size_t i = 0; i < 10; ++i)
+                              {
+                                  KafkaTestUtility::ProduceMessages(topic, partition, {{Headers{}, "key" + std::to_string(i), "value" + std::to_string(i)}});
+                                  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                              }
+                          });
+
+    // Keep lingering until 5 records are accumulated
+    const auto start = std::chrono::steady_clock::now();
+    auto records = consumer.poll(5, KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT);
+    std::cout << "[" << Utility::getCurrentTime() << "] polled " << records.size() << " records" << std::endl;
+    EXPECT_GE(records.size(), 5);
+    EXPECT_LE(records.size(), 8);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT);
+
+    fut.get();
+
+    // Never more than `max.poll.records`
+    std::size_t numConsumed = records.size();
+    records = consumer.poll(100, std::chrono::seconds(2));
+    EXPECT_LE(records.size(), 8);
+    numConsumed += records.size();
+
+    // Return once the deadline is reached, -- with whatever accumulated
+    const auto lingerStart = std::chrono::steady_clock::now();
+    numConsumed += consumer.poll(100, std::chrono::seconds(1)).size();
+    EXPECT_GE(std::chrono::steady_clock::now() - lingerStart, std::chrono::milliseconds(900));
+
+    EXPECT_EQ(10, numConsumed);
+
+    consumer.close();
+}
+
+TEST(KafkaAutoCommitConsumer, PollWithLingerWithoutDeadline)
+{
+    const Topic     topic     = Utility::getRandomString();
+    const Partition partition = 0;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ConsumerConfig::AUTO_OFFSET_RESET, "earliest")
+                       .put(ConsumerConfig::MAX_POLL_RECORDS,  "8");
+
+    KafkaAutoCommitConsumer consumer(props);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    consumer.subscribe({topic});
+
+    // The messages would only be sent after a while, -- thus the poll must keep waiting for them
+    const auto sendDelay = std::chrono::seconds(3);
+    auto fut = std::async(std::launch::async,
+                          [topic, partition, sendDelay]() {
+                              std::this_thread::sleep_for(sendDelay);
+                              for (std::size_t i = 0; i < 5; ++i)
+                              {
+                                  KafkaTestUtility::ProduceMessages(topic, partition, {{Headers{}, "key" + std::to_string(i), "value" + std::to_string(i)}});
+                              }
+                          });
+
+    // With the max duration (i.e, infinite timeout), it keeps lingering until 5 records are accumulated
+    const auto start = std::chrono::steady_clock::now();
+    auto records = consumer.poll(5, std::chrono::milliseconds::max());
+    std::cout << "[" << Utility::getCurrentTime() << "] polled " << records.size() << " records" << std::endl;
+    EXPECT_EQ(5, records.size());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, sendDelay);
+
+    fut.get();
+
+    consumer.close();
+}
+
+TEST(KafkaAutoCommitConsumer, PrioritizeLaggingPartitions)
+{
+    const Topic topic = Utility::getRandomString();
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    KafkaTestUtility::CreateKafkaTopic(topic, 2, 3);
+
+    // Partition 0 would lag far behind, while partition 1 would soon catch up
+    const TopicPartition laggingTp{topic, 0};
+    const TopicPartition headTp{topic, 1};
+
+    std::vector<std::tuple<Headers, std::string, std::string>> messages;
+    for (std::size_t i = 0; i < 2000; ++i)
+    {
+        messages.emplace_back(Headers{}, "", "value" + std::to_string(i));
+    }
+    KafkaTestUtility::ProduceMessages(topic, laggingTp.second, messages);
+    KafkaTestUtility::ProduceMessages(topic, headTp.second, {messages.cbegin(), messages.cbegin() + 10});
+
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ConsumerConfig::AUTO_OFFSET_RESET, "earliest")
+                       .put(ConsumerConfig::MAX_POLL_RECORDS,  "10");
+
+    KafkaAutoCommitConsumer consumer(props);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    consumer.assign({laggingTp, headTp});
+    consumer.setPrioritizationPolicy(Consumer::prioritizeLaggingPartitions(100), std::chrono::milliseconds(0));
+
+    // Poll all messages
+    bool headPausedOnce = false;
+    std::size_t numConsumed = 0;
+    const auto end = std::chrono::steady_clock::now() + KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT;
+    while (numConsumed < messages.size() + 10 && std::chrono::steady_clock::now() < end)
+    {
+        numConsumed += consumer.poll(KafkaTestUtility::POLL_INTERVAL).size();
+
+        const auto paused = consumer.pausedByPrioritization();
+        // The lagging partition would never be paused
+        EXPECT_EQ(0, paused.count(laggingTp));
+        headPausedOnce = headPausedOnce || (paused.count(headTp) > 0);
+    }
+    EXPECT_EQ(messages.size() + 10, numConsumed);
+    EXPECT_TRUE(headPausedOnce);
+
+    // The lags have evened out, -- nothing would be paused
+    consumer.poll(KafkaTestUtility::POLL_INTERVAL);
+    EXPECT_TRUE(consumer.pausedByPrioritization().empty());
+
+    consumer.close();
+}
+
+TEST(KafkaManualCommitConsumer, MergeWithEventTime)
+{
+    const Topic       topic         = Utility::getRandomString();
+    const int         numPartitions = 3;
+    const std::size_t numPerPartition = 5;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    KafkaTestUtility::CreateKafkaTopic(topic, numPartitions, 3);
+
+    // Send the messages to the partitions in turn, -- thus the timestamps are interleaved among partitions
+    for (std::size_t i = 0; i < numPerPartition; ++i)
+    {
+        for (Partition partition = 0; partition < numPartitions; ++partition)
+        {
+            KafkaTestUtility::ProduceMessages(topic, partition, {{Headers{}, "", "value" + std::to_string(i)}});
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig().put(ConsumerConfig::AUTO_OFFSET_RESET, "earliest");
+
+    KafkaManualCommitConsumer consumer(props);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    const TopicPartitions tps = {{topic, 0}, {topic, 1}, {topic, 2}};
+    consumer.assign(tps);
+
+    EventTimeMerger merger(100, std::chrono::seconds(1));
+    merger.assign(tps);
+
+    // The records would be emitted in event-time order
+    std::vector<Timestamp::Value> timestamps;
+    const auto end = std::chrono::steady_clock::now() + KafkaTestUtility::MAX_POLL_MESSAGES_TIMEOUT;
+    while (timestamps.size() < numPartitions * numPerPartition && std::chrono::steady_clock::now() < end)
+    {
+        for (const auto& record: merger.poll(consumer, KafkaTestUtility::POLL_INTERVAL))
+        {
+            if (record.error()) continue;
+
+            std::cout << "[" << Utility::getCurrentTime() << "] " << record.toString() << std::endl;
+            timestamps.emplace_back(record.timestamp().msSinceEpoch);
+        }
+    }
+
+    EXPECT_EQ(numPartitions * numPerPartition, timestamps.size());
+    EXPECT_TRUE(std::is_sorted(timestamps.cbegin(), timestamps.cend()));
+
+    // Everything has been emitted, -- thus safe to commit
+    const TopicPartitionOffsets committable = merger.committableOffsets();
+    EXPECT_EQ(TopicPartitionOffsets({{{topic, 0}, numPerPartition}, {{topic, 1}, numPerPartition}, {{topic, 2}, numPerPartition}}), committable);
+    consumer.commitSync(committable);
+
+    consumer.close();
+}
+
 TEST(KafkaManualCommitConsumer, NoOffsetCommitCallback)
 {
     const Topic     topic     = Utility::getRandomString();
@@ -389,6 +1088,74 @@ TEST(KafkaManualCommitConsumer, OffsetCommitCallback)
     std::cout << "[" << Utility::getCurrentTime() << "] Consumer closed" << std::endl;
 }
 
+TEST(KafkaManualCommitConsumer, CoalescedOffsetCommits)
+{
+    const Topic     topic     = Utility::getRandomString();
+    const Partition partition = 0;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    // Prepare some messages to send
+    const std::vector<std::tuple<Headers, std::string, std::string>> messages = {
+        {Headers{}, "key1", "value1"},
+        {Headers{}, "key2", "value2"},
+        {Headers{}, "key3", "value3"},
+    };
+
+    // Send the messages
+    KafkaTestUtility::ProduceMessages(topic, partition, messages);
+
+    // The manual-commit consumer, -- with a long coalescing interval, all commits would be merged and sent while closing
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ConsumerConfig::AUTO_OFFSET_RESET,             "earliest")
+                       .put(ConsumerConfig::MAX_POLL_RECORDS,              "1")
+                       .put(ConsumerConfig::COMMIT_COALESCING_INTERVAL_MS, "3600000");
+
+    const TopicPartition tp{topic, partition};
+    Offset lastOffset = 0;
+    std::size_t commitCbCount = 0;
+    {
+        KafkaManualCommitConsumer consumer(props);
+        std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+        consumer.subscribe({topic});
+
+        for (std::size_t numMsgPolled = 0; numMsgPolled < messages.size(); )
+        {
+            auto records = consumer.poll(KafkaTestUtility::POLL_INTERVAL);
+            numMsgPolled += records.size();
+
+            for (const auto& record: records)
+            {
+                lastOffset = record.offset();
+                consumer.commitAsync(record,
+                                     [&commitCbCount, &lastOffset, tp](const TopicPartitionOffsets& tpos, std::error_code ec) {
+                                         std::cout << "[" << Utility::getCurrentTime() << "] offset commit callback for offset[" << toString(tpos) << "], result[" << ec.message()<< "]" << std::endl;
+                                         EXPECT_FALSE(ec);
+                                         EXPECT_EQ(lastOffset + 1, tpos.at(tp));
+                                         ++commitCbCount;
+                                     });
+            }
+        }
+
+        // Nothing sent yet
+        EXPECT_EQ(messages.size(), consumer.commitStatistics().requested);
+        EXPECT_EQ(0, consumer.commitStatistics().sent);
+
+        consumer.close();
+
+        // All merged into one OffsetCommit request
+        EXPECT_EQ(messages.size(), commitCbCount);
+        EXPECT_EQ(1, consumer.commitStatistics().sent);
+        EXPECT_EQ(messages.size() - 1, consumer.commitStatistics().saved());
+    }
+
+    // Check the committed offset
+    KafkaManualCommitConsumer consumer(props);
+    consumer.assign({tp});
+    EXPECT_EQ(lastOffset + 1, consumer.committed(tp));
+}
+
 TEST(KafkaManualCommitConsumer, OffsetCommitCallbackTriggeredBeforeClose)
 {
     const Topic     topic     = Utility::getRandomString();
@@ -514,6 +1281,54 @@ TEST(KafkaManualCommitConsumer, OffsetCommitCallback_ManuallyPollEvents)
     consumer.close();
 }
 
+TEST(KafkaManualCommitConsumer, CommittedAndPositionsForManyPartitions)
+{
+    const Topic topic         = Utility::getRandomString();
+    const int   numPartitions = 16;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "] would be used" << std::endl;
+
+    KafkaTestUtility::CreateKafkaTopic(topic, numPartitions, 3);
+
+    KafkaManualCommitConsumer consumer(KafkaTestUtility::GetKafkaClientCommonConfig());
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    TopicPartitions       tps;
+    TopicPartitionOffsets tposToCommit;
+    for (Partition partition = 0; partition < numPartitions; ++partition)
+    {
+        tps.emplace(topic, partition);
+        // Only commit offsets for the even partitions
+        if (partition % 2 == 0) tposToCommit.emplace(TopicPartition{topic, partition}, partition);
+    }
+
+    consumer.assign(tps);
+
+    // Nothing fetched, nor committed yet
+    for (const auto& tpo: consumer.positions(tps))
+    {
+        EXPECT_EQ(RD_KAFKA_OFFSET_INVALID, tpo.second);
+    }
+    for (const auto& tpo: consumer.committed(tps))
+    {
+        EXPECT_EQ(RD_KAFKA_OFFSET_INVALID, tpo.second);
+    }
+
+    consumer.commitSync(tposToCommit);
+
+    // Fetch the committed offsets with one request
+    const auto committed = consumer.committed(tps, std::chrono::seconds(10));
+    ASSERT_EQ(tps.size(), committed.size());
+    for (const auto& tpo: committed)
+    {
+        const Partition partition = tpo.first.second;
+        EXPECT_EQ((partition % 2 == 0 ? static_cast<Offset>(partition) : RD_KAFKA_OFFSET_INVALID), tpo.second);
+        EXPECT_EQ(tpo.second, consumer.committed(tpo.first));
+    }
+
+    consumer.close();
+}
+
 TEST(KafkaManualCommitConsumer, OffsetCommitAndPosition)
 {
     const Topic     topic     = Utility::getRandomString();
@@ -954,6 +1769,71 @@ TEST(KafkaAutoCommitConsumer, RebalancePartitionsAssign)
     consumer.close();
 }
 
+TEST(KafkaAutoCommitConsumer, CooperativeRebalance)
+{
+    const Topic       topic         = Utility::getRandomString();
+    const std::string group         = Utility::getRandomString();
+    const int         numPartitions = 6;
+
+    std::cout << "[" << Utility::getCurrentTime() << "] Topic[" << topic << "], group[" << group << "] would be used" << std::endl;
+
+    KafkaTestUtility::CreateKafkaTopic(topic, numPartitions, 3);
+
+    // Prepare the consumer
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ConsumerConfig::GROUP_ID,                      group)
+                       .put(ConsumerConfig::PARTITION_ASSIGNMENT_STRATEGY, "cooperative-sticky");
+
+    KafkaAutoCommitConsumer consumer(props);
+    std::cout << "[" << Utility::getCurrentTime() << "] " << consumer.name() << " started" << std::endl;
+
+    std::vector<TopicPartitions> partitionsAssigned;
+    std::vector<TopicPartitions> partitionsRevoked;
+    consumer.subscribe({topic},
+                        [&partitionsAssigned, &partitionsRevoked](Consumer::RebalanceEventType et, const TopicPartitions& tps) {
+                            if (et == Consumer::RebalanceEventType::PartitionsAssigned) {
+                                std::cout << "[" << Utility::getCurrentTime() << "] Consumer PartitionsAssigned: " << toString(tps) << std::endl;
+                                if (!tps.empty()) partitionsAssigned.emplace_back(tps);
+                            } else if (et == Consumer::RebalanceEventType::PartitionsRevoked) {
+                                std::cout << "[" << Utility::getCurrentTime() << "] Consumer PartitionsRevoked: " << toString(tps) << std::endl;
+                                if (!tps.empty()) partitionsRevoked.emplace_back(tps);
+                            }
+                        });
+
+    // Start another consumer, and it would take some partitions away during the time
+    std::cout << "[" << Utility::getCurrentTime() << "] Second consumer will start" << std::endl;
+    auto fut = std::async(std::launch::async,
+                          [props, topic]() {
+                              KafkaAutoCommitConsumer anotherConsumer(props);
+                              anotherConsumer.subscribe({topic});
+                              KafkaTestUtility::ConsumeMessagesUntilTimeout(anotherConsumer, std::chrono::seconds(10));
+                          });
+
+    // Keep polling, in order to trigger any callback
+    const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    do
+    {
+        consumer.poll(KafkaTestUtility::POLL_INTERVAL);
+    } while (std::chrono::steady_clock::now() < end);
+
+    fut.get();
+    std::cout << "[" << Utility::getCurrentTime() << "] Second consumer closed" << std::endl;
+
+    // 1st: all partitions; 2nd: the ones taken back (after the other consumer closed)
+    ASSERT_EQ(2, partitionsAssigned.size());
+    EXPECT_EQ(static_cast<std::size_t>(numPartitions), partitionsAssigned[0].size());
+
+    // Only part of the partitions were revoked (i.e, the delta), -- the others kept being consumed
+    ASSERT_EQ(1, partitionsRevoked.size());
+    EXPECT_FALSE(partitionsRevoked[0].empty());
+    EXPECT_LT(partitionsRevoked[0].size(), partitionsAssigned[0].size());
+
+    // The same partitions were assigned back
+    EXPECT_EQ(partitionsRevoked[0], partitionsAssigned[1]);
+
+    consumer.close();
+}
+
 TEST(KafkaAutoCommitConsumer, ThreadCount)
 {
     {
@@ -8,6 +8,8 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <poll.h>
+
 using namespace KAFKA_API;
 
 
@@ -359,6 +361,45 @@ TEST(KafkaAsyncProducer, DeliveryCallback_ManuallyPollEvents)
     }
 }
 
+TEST(KafkaAsyncProducer, DeliveryCallback_DrainWithEventFd)
+{
+    const Topic     topic     = Utility::getRandomString();
+    const Partition partition = 0;
+    const int       numMsgs   = 3;
+
+    int msgSentCnt = 0;
+
+    Producer::Callback drCallback =
+        [&msgSentCnt](const Producer::RecordMetadata& metadata, std::error_code ec) {
+            std::cout << "[" << Utility::getCurrentTime() << "] Delivery callback called. RecordMetadata: " << metadata.toString() << std::endl;
+            EXPECT_FALSE(ec);
+            ++msgSentCnt;
+        };
+
+    KafkaAsyncProducer producer(KafkaTestUtility::GetKafkaClientCommonConfig(), KafkaClient::EventsPollingOption::Manual);
+
+    struct pollfd pfd{producer.eventFd(), POLLIN, 0};
+
+    for (int i = 0; i < numMsgs; ++i)
+    {
+        producer.send(ProducerRecord(topic, partition, NullKey, NullValue, i), drCallback);
+    }
+
+    // Wait (with the event loop) for the delivery callbacks
+    const auto end = std::chrono::steady_clock::now() + KafkaTestUtility::MAX_DELIVERY_TIMEOUT;
+    while (msgSentCnt < numMsgs && std::chrono::steady_clock::now() < end)
+    {
+        if (poll(&pfd, 1, static_cast<int>(KafkaTestUtility::POLL_INTERVAL.count())) > 0)
+        {
+            producer.drain();
+        }
+    }
+
+    EXPECT_EQ(numMsgs, msgSentCnt);
+
+    producer.close();
+}
+
 TEST(KafkaAsyncProducer, NoBlockSendingWhileQueueIsFull_ManuallyPollEvents)
 {
     const Topic topic       = Utility::getRandomString();
@@ -503,3 +544,34 @@ TEST(KafkaAsyncProducer, CopyRecordValueWithinSend)
     }
 }
 
+TEST(KafkaSyncProducer, CachedBrokerMetadata)
+{
+    const Topic topic         = Utility::getRandomString();
+    const int   numPartitions = 3;
+    KafkaTestUtility::CreateKafkaTopic(topic, numPartitions, 1);
+
+    const auto props = KafkaTestUtility::GetKafkaClientCommonConfig()
+                       .put(ProducerConfig::METADATA_CACHE_TTL_MS, "60000");
+
+    KafkaSyncProducer producer(props);
+
+    auto brokerMetadata = producer.fetchBrokerMetadata(topic);
+    ASSERT_TRUE(brokerMetadata);
+    EXPECT_EQ(numPartitions, brokerMetadata->partitions().size());
+
+    // Served from the cache, -- no request sent to the brokers
+    const auto before = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10000; ++i)
+    {
+        auto cached = producer.fetchBrokerMetadata(topic);
+        ASSERT_TRUE(cached);
+        EXPECT_EQ(brokerMetadata->toString(), cached->toString());
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before);
+    std::cout << "[" << Utility::getCurrentTime() << "] 10000 lookups took " << elapsed.count() << " us" << std::endl;
+
+    // Fetched again after the invalidation
+    producer.invalidateBrokerMetadata(topic);
+    EXPECT_TRUE(producer.fetchBrokerMetadata(topic));
+}
+
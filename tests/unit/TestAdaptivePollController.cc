@@ -0,0 +1,70 @@
+#include "kafka/AdaptivePollController.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+
+namespace Kafka = KAFKA_API;
+
+TEST(AdaptivePollController, Disabled)
+{
+    Kafka::AdaptivePollController controller(500, 500, std::chrono::milliseconds(1000));
+    EXPECT_FALSE(controller.isEnabled());
+
+    const auto start = Kafka::AdaptivePollController::Clock::now();
+
+    // Always the upper bound, no matter how slow the processing is, or how small the lag is
+    EXPECT_EQ(500, controller.beforePoll(0, start));
+    controller.afterPoll(500, start);
+    EXPECT_EQ(500, controller.beforePoll(0, start + std::chrono::seconds(10)));
+}
+
+TEST(AdaptivePollController, ShrinkWithSlowProcessing)
+{
+    using namespace std::chrono;
+
+    Kafka::AdaptivePollController controller(10, 500, milliseconds(1000));
+    EXPECT_TRUE(controller.isEnabled());
+
+    const auto start = Kafka::AdaptivePollController::Clock::now();
+
+    // Nothing observed yet, -- start with the upper bound
+    EXPECT_EQ(500, controller.beforePoll(-1, start));
+    controller.afterPoll(500, start);
+
+    // 10ms per record, -- only 100 records could be processed within the target interval
+    EXPECT_EQ(100, controller.beforePoll(-1, start + milliseconds(5000)));
+    EXPECT_EQ(1, controller.metrics().decreases);
+    EXPECT_DOUBLE_EQ(10000, controller.metrics().recordProcessingTimeUs);
+
+    // Even slower, but never below the lower bound
+    controller.afterPoll(100, start + milliseconds(5000));
+    EXPECT_EQ(10, controller.beforePoll(-1, start + milliseconds(5000) + seconds(100)));
+}
+
+TEST(AdaptivePollController, GrowGraduallyWhileLagging)
+{
+    using namespace std::chrono;
+
+    Kafka::AdaptivePollController controller(10, 500, milliseconds(1000));
+
+    auto now = Kafka::AdaptivePollController::Clock::now();
+
+    // Caught up, -- no need to wait for more records than the lag
+    EXPECT_EQ(20, controller.beforePoll(20, now));
+    controller.afterPoll(20, now);
+
+    // Lagging behind with fast processing, -- the batch would be doubled for each poll, until the upper bound
+    const std::size_t expected[] = {40, 80, 160, 320, 500, 500};
+    for (auto e: expected)
+    {
+        now += microseconds(20);
+        EXPECT_EQ(e, controller.beforePoll(100000, now));
+        controller.afterPoll(e, now);
+    }
+
+    EXPECT_EQ(5, controller.metrics().increases);
+    EXPECT_EQ(1, controller.metrics().decreases);
+    EXPECT_EQ(100000, controller.metrics().lag);
+}
+
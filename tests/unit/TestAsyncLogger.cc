@@ -0,0 +1,130 @@
+#include "kafka/AsyncLogger.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Kafka = KAFKA_API;
+
+namespace {
+
+std::vector<std::string> splitLines(const std::string& output)
+{
+    std::vector<std::string> lines;
+    std::istringstream iss(output);
+    for (std::string line; std::getline(iss, line);) lines.emplace_back(line);
+    return lines;
+}
+
+} // end of namespace
+
+TEST(AsyncLogger, WriteFromMultipleThreads)
+{
+    const int numThreads        = 4;
+    const int numLinesPerThread = 500;
+
+    std::mutex    outputLock;
+    std::string   output;
+    std::uint64_t dropped = 0;
+
+    {
+        Kafka::AsyncLogger asyncLogger(256, [&outputLock, &output](const char* lines, std::size_t len) {
+            std::lock_guard<std::mutex> lock(outputLock);
+            output.append(lines, len);
+        });
+
+        // Works as a `Logger`
+        const Kafka::Logger logger = asyncLogger;
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < numThreads; ++i)
+        {
+            threads.emplace_back([&logger, i]() {
+                for (int j = 0; j < numLinesPerThread; ++j)
+                {
+                    logger(LOG_INFO, __FILE__, __LINE__, ("thread" + std::to_string(i) + " line" + std::to_string(j)).c_str());
+                    if (j % 50 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+        }
+        for (auto& thread: threads) thread.join();
+
+        dropped = asyncLogger.dropped();
+        std::cout << "[" << Kafka::Utility::getCurrentTime() << "] dropped: " << dropped << std::endl;
+    }
+
+    const auto lines = splitLines(output);
+    std::size_t numNormalLines = 0;
+    for (const auto& line: lines)
+    {
+        // E.g, "[2021-03-01 12:00:00.123456]INFO thread0 line0"
+        ASSERT_EQ('[', line[0]);
+        ASSERT_EQ(27, line.find(']'));
+        const bool isNormalLine  = (line.find("]INFO thread") != std::string::npos);
+        const bool isDroppedLine = (line.find("]WARNING ") != std::string::npos && line.find(" log lines dropped") != std::string::npos);
+        EXPECT_TRUE(isNormalLine || isDroppedLine) << line;
+
+        if (isNormalLine) ++numNormalLines;
+    }
+
+    // The lines would be drained before the background thread stops
+    EXPECT_EQ(numThreads * numLinesPerThread, numNormalLines + dropped);
+}
+
+TEST(AsyncLogger, DropWhileFull)
+{
+    std::atomic<bool> blocked(false);
+    std::atomic<bool> released(false);
+    std::mutex        outputLock;
+    std::string       output;
+
+    {
+        Kafka::AsyncLogger asyncLogger(2, [&](const char* lines, std::size_t len) {
+            blocked = true;
+            while (!released) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            std::lock_guard<std::mutex> lock(outputLock);
+            output.append(lines, len);
+        });
+
+        // The background thread would be blocked within the sink
+        asyncLogger(LOG_ERR, __FILE__, __LINE__, "first");
+        while (!blocked) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        // Only 2 lines could be held by the ring
+        for (int i = 0; i < 10; ++i) asyncLogger(LOG_ERR, __FILE__, __LINE__, "more");
+        EXPECT_EQ(8, asyncLogger.dropped());
+
+        released = true;
+    }
+
+    const auto lines = splitLines(output);
+    ASSERT_EQ(4, lines.size());
+    EXPECT_NE(std::string::npos, lines[0].find("]ERR first"));
+    EXPECT_NE(std::string::npos, lines[1].find("]ERR more"));
+    EXPECT_NE(std::string::npos, lines[2].find("]ERR more"));
+    EXPECT_NE(std::string::npos, lines[3].find("]WARNING 8 log lines dropped"));
+}
+
+TEST(AsyncLogger, TruncateLongLine)
+{
+    std::string output;
+
+    {
+        Kafka::AsyncLogger asyncLogger(Kafka::AsyncLogger::DEFAULT_CAPACITY, [&output](const char* lines, std::size_t len) { output.append(lines, len); });
+        asyncLogger(LOG_DEBUG, __FILE__, __LINE__, std::string(4096, 'x').c_str());
+    }
+
+    const auto lines = splitLines(output);
+    ASSERT_EQ(1, lines.size());
+    EXPECT_EQ(1023, output.size());
+    EXPECT_EQ('\n', output.back());
+}
+
@@ -100,3 +100,69 @@ TEST(BrokerMetadata, IncompleteInfo)
     EXPECT_EQ(expectedMetadata, metadata.toString());
 }
 
+TEST(BrokerMetadata, LeaderRouting)
+{
+    Kafka::BrokerMetadata metadata("topicName");
+
+    metadata.addNode(2, "server2", 9000);
+    metadata.addNode(1, "server1", 9000);
+    metadata.addNode(1, "server1", 9001);   // Updated
+
+    ASSERT_EQ(2, metadata.nodeTable().size());
+    EXPECT_EQ(1, metadata.nodeTable()[0].id);
+    EXPECT_EQ(9001, metadata.nodeTable()[0].port);
+    EXPECT_EQ(nullptr, metadata.node(3));
+
+    const Kafka::BrokerMetadata::Node::Id replicas[] = {1, 2};
+    const Kafka::BrokerMetadata::Node::Id isrs[]     = {2};
+
+    // Partition 2 is missing (e.g, with error)
+    metadata.addPartition(3, 1, replicas, 2, isrs, 1);
+    metadata.addPartition(0, 2, replicas, 2, isrs, 1);
+    metadata.addPartition(1, 1, replicas, 2, replicas, 2);
+    metadata.addPartition(4, Kafka::BrokerMetadata::NO_LEADER, replicas, 2, nullptr, 0);
+
+    EXPECT_EQ(4, metadata.numPartitions());
+    EXPECT_FALSE(metadata.hasPartition(2));
+
+    EXPECT_EQ(2,  metadata.leaderFor(0));
+    EXPECT_EQ(1,  metadata.leaderFor(1));
+    EXPECT_EQ(-1, metadata.leaderFor(2));
+    EXPECT_EQ(1,  metadata.leaderFor(3));
+    EXPECT_EQ(-1, metadata.leaderFor(4));
+    EXPECT_EQ(-1, metadata.leaderFor(5));
+
+    EXPECT_EQ(std::vector<Kafka::Partition>({1, 3}), metadata.partitionsLedBy(1));
+    EXPECT_EQ(std::vector<Kafka::Partition>({0}),    metadata.partitionsLedBy(2));
+    EXPECT_TRUE(metadata.partitionsLedBy(3).empty());
+
+    const auto partitionReplicas = metadata.replicasFor(1);
+    EXPECT_EQ(std::vector<Kafka::BrokerMetadata::Node::Id>({1, 2}), std::vector<Kafka::BrokerMetadata::Node::Id>(partitionReplicas.begin(), partitionReplicas.end()));
+    EXPECT_EQ(1, metadata.inSyncReplicasFor(3).size());
+    EXPECT_TRUE(metadata.inSyncReplicasFor(4).empty());
+    EXPECT_TRUE(metadata.replicasFor(2).empty());
+
+    // The map-based views are cached, -- until the metadata changes
+    EXPECT_EQ(4, metadata.partitions().size());
+    EXPECT_EQ(&metadata.partitions(), &metadata.partitions());
+    EXPECT_EQ(metadata.nodes()[0], metadata.nodes()[0]);
+    EXPECT_EQ("originatingNode[], topic[topicName], partitions{"
+              "0: leader[server2:9000/2], replicas[server1:9001/1, server2:9000/2], inSyncReplicas[server2:9000/2]; "
+              "1: leader[server1:9001/1], replicas[server1:9001/1, server2:9000/2], inSyncReplicas[server1:9001/1, server2:9000/2]; "
+              "3: leader[server1:9001/1], replicas[server1:9001/1, server2:9000/2], inSyncReplicas[server2:9000/2]; "
+              "4: leader[-:-/-1], replicas[server1:9001/1, server2:9000/2], inSyncReplicas[]}",
+              metadata.toString());
+
+    // The views would be reconstructed after changes
+    metadata.addPartition(2, 2, replicas, 2, isrs, 1);
+    EXPECT_EQ(5, metadata.partitions().size());
+    EXPECT_EQ(2, metadata.partitions().at(2).leader);
+
+    metadata.addNode(3, "server3", 9000);
+    EXPECT_EQ(3, metadata.nodes().size());
+
+    // The copy shares the views
+    const Kafka::BrokerMetadata copied = metadata;
+    EXPECT_EQ(&metadata.partitions(), &copied.partitions());
+}
+
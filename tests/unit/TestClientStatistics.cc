@@ -0,0 +1,183 @@
+#include "kafka/ClientStatistics.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+namespace Kafka = KAFKA_API;
+
+namespace {
+
+// Abridged from the statistics emitted by librdkafka (for a consumer)
+const std::string STATS_JSON = R"({
+  "name": "rdkafka#consumer-1", "client_id": "rdkafka", "type": "consumer",
+  "ts": 5016483227792, "time": 1527060869, "replyq": 3, "msg_cnt": 0, "msg_size": 0, "msg_max": 100000, "msg_size_max": 1073741824,
+  "simple_cnt": 0, "metadata_cache_cnt": 1,
+  "brokers": {
+    "localhost:9092/2": {
+      "name": "localhost:9092/2", "nodeid": 2, "nodename": "localhost:9092", "source": "learned", "state": "UP", "stateage": 9057234,
+      "outbuf_cnt": 0, "outbuf_msg_cnt": 0, "waitresp_cnt": 1, "waitresp_msg_cnt": 0,
+      "tx": 320, "txbytes": 84283, "txerrs": 0, "txretries": 0, "req_timeouts": 0, "rx": 320, "rxbytes": 15708, "rxerrs": 1,
+      "int_latency": { "min": 0, "max": 0, "avg": 0, "sum": 0, "stddev": 0, "p50": 0, "p75": 0, "p90": 0, "p95": 0, "p99": 0, "p99_99": 0, "outofrange": 0, "hdrsize": 11376, "cnt": 0 },
+      "rtt": { "min": 1580, "max": 3389, "avg": 2349, "sum": 79868, "stddev": 474, "p50": 2319, "p75": 2543, "p90": 3183, "p95": 3199, "p99": 3391, "p99_99": 3391, "outofrange": 0, "hdrsize": 13424, "cnt": 34 },
+      "throttle": { "min": 0, "max": 5, "avg": 1, "sum": 10, "stddev": 0, "p50": 0, "p75": 0, "p90": 0, "p95": 5, "p99": 5, "p99_99": 5, "outofrange": 0, "hdrsize": 17520, "cnt": 10 },
+      "req": { "Produce": 0, "Fetch": 300, "Offset": 2, "Metadata": 3 },
+      "toppars": { "test-0": { "topic": "test", "partition": 0 } }
+    },
+    "GroupCoordinator": {
+      "name": "GroupCoordinator", "nodeid": -1, "state": "UP", "rtt": { "min": 0, "max": 0, "avg": 0, "cnt": 0 }
+    }
+  },
+  "topics": {
+    "test": {
+      "topic": "test", "age": 9060, "metadata_age": 9060,
+      "batchsize": { "min": 0, "max": 0, "avg": 0, "cnt": 0 },
+      "partitions": {
+        "0": {
+          "partition": 0, "broker": 2, "leader": 2, "desired": true, "unknown": false,
+          "msgq_cnt": 0, "msgq_bytes": 0, "xmit_msgq_cnt": 0, "xmit_msgq_bytes": 0, "fetchq_cnt": 7, "fetchq_size": 840,
+          "fetch_state": "active", "query_offset": -1, "next_offset": 1006, "app_offset": 1000, "stored_offset": 1000,
+          "commited_offset": 990, "committed_offset": 990, "eof_offset": -1001, "lo_offset": 0, "hi_offset": 1050, "ls_offset": 1050,
+          "consumer_lag": 50, "txmsgs": 0, "txbytes": 0, "rxmsgs": 1006, "rxbytes": 120720, "msgs": 1006, "rx_ver_drops": 0, "msgs_inflight": 0
+        },
+        "-1": {
+          "partition": -1, "broker": -1, "leader": -1, "desired": false, "msgq_cnt": 0, "consumer_lag": -1
+        },
+        "1": {
+          "partition": 1, "leader": 3, "fetchq_cnt": 0, "committed_offset": -1001, "hi_offset": 20, "consumer_lag": -1
+        }
+      }
+    }
+  },
+  "cgrp": { "state": "up", "stateage": 8997, "join_state": "started", "rebalance_age": 8997, "rebalance_cnt": 1, "rebalance_reason": "", "assignment_size": 2 },
+  "tx": 340, "tx_bytes": 86000, "rx": 340, "rx_bytes": 136000, "txmsgs": 0, "txmsg_bytes": 0, "rxmsgs": 1006, "rxmsg_bytes": 120720
+})";
+
+} // end of namespace
+
+TEST(ClientStatistics, Parse)
+{
+    Kafka::ClientStatistics stats;
+    ASSERT_TRUE(stats.parse(STATS_JSON));
+
+    EXPECT_EQ("rdkafka#consumer-1", stats.name);
+    EXPECT_EQ("rdkafka", stats.clientId);
+    EXPECT_EQ("consumer", stats.type);
+    EXPECT_EQ(5016483227792, stats.ts);
+    EXPECT_EQ(1527060869, stats.time);
+    EXPECT_EQ(3, stats.replyq);
+    EXPECT_EQ(340, stats.tx);
+    EXPECT_EQ(1006, stats.rxmsgs);
+    EXPECT_EQ(120720, stats.rxmsgBytes);
+
+    ASSERT_EQ(2, stats.brokers.size());
+    const auto& broker = stats.brokers[0];
+    EXPECT_EQ("localhost:9092/2", broker.name);
+    EXPECT_EQ(2, broker.nodeId);
+    EXPECT_EQ("UP", broker.state);
+    EXPECT_EQ(1, broker.waitrespCnt);
+    EXPECT_EQ(320, broker.tx);
+    EXPECT_EQ(1, broker.rxerrs);
+    EXPECT_EQ(1580, broker.rtt.min);
+    EXPECT_EQ(3389, broker.rtt.max);
+    EXPECT_EQ(2349, broker.rtt.avg);
+    EXPECT_EQ(3391, broker.rtt.p99);
+    EXPECT_EQ(34, broker.rtt.cnt);
+    EXPECT_EQ(5, broker.throttle.max);
+    EXPECT_EQ(10, broker.throttle.cnt);
+    EXPECT_EQ(-1, stats.brokers[1].nodeId);
+
+    ASSERT_EQ(1, stats.topics.size());
+    const auto& topic = stats.topics[0];
+    EXPECT_EQ("test", topic.topic);
+
+    // The internal unassigned partition (-1) is excluded
+    ASSERT_EQ(2, topic.partitions.size());
+    EXPECT_EQ(0, topic.partitions[0].partition);
+    EXPECT_EQ(2, topic.partitions[0].leader);
+    EXPECT_EQ(7, topic.partitions[0].fetchqCnt);
+    EXPECT_EQ(840, topic.partitions[0].fetchqSize);
+    EXPECT_EQ(990, topic.partitions[0].committedOffset);
+    EXPECT_EQ(1050, topic.partitions[0].hiOffset);
+    EXPECT_EQ(50, topic.partitions[0].consumerLag);
+    EXPECT_EQ(1006, topic.partitions[0].rxmsgs);
+    EXPECT_EQ(1, topic.partitions[1].partition);
+    EXPECT_EQ(RD_KAFKA_OFFSET_INVALID, topic.partitions[1].committedOffset);
+    EXPECT_EQ(-1, topic.partitions[1].consumerLag);
+
+    EXPECT_EQ(50, stats.totalConsumerLag());
+
+    EXPECT_EQ("up", stats.consumerGroup.state);
+    EXPECT_EQ("started", stats.consumerGroup.joinState);
+    EXPECT_EQ(1, stats.consumerGroup.rebalanceCnt);
+    EXPECT_EQ(2, stats.consumerGroup.assignmentSize);
+}
+
+TEST(ClientStatistics, ReuseForNextParse)
+{
+    Kafka::ClientStatistics stats;
+    ASSERT_TRUE(stats.parse(STATS_JSON));
+    ASSERT_EQ(2, stats.brokers.size());
+    ASSERT_EQ(2, stats.topics[0].partitions.size());
+
+    // Fewer brokers/partitions, and some fields are missing
+    const std::string json = R"({"name": "rdkafka#producer-1", "type": "producer", "msg_cnt": 12,
+                                 "brokers": {"b:9092/1": {"name": "b:9092/1", "nodeid": 1, "state": "DOWN"}},
+                                 "topics": {"t": {"topic": "t", "partitions": {"3": {"partition": 3, "leader": 1, "msgq_cnt": 5, "txmsgs": 100}}}}})";
+    ASSERT_TRUE(stats.parse(json));
+
+    EXPECT_EQ("rdkafka#producer-1", stats.name);
+    EXPECT_EQ("producer", stats.type);
+    EXPECT_EQ(12, stats.msgCnt);
+
+    ASSERT_EQ(1, stats.brokers.size());
+    EXPECT_EQ("b:9092/1", stats.brokers[0].name);
+    EXPECT_EQ("DOWN", stats.brokers[0].state);
+    EXPECT_EQ(0, stats.brokers[0].tx);
+    EXPECT_EQ(0, stats.brokers[0].rtt.cnt);
+
+    ASSERT_EQ(1, stats.topics.size());
+    ASSERT_EQ(1, stats.topics[0].partitions.size());
+    EXPECT_EQ("t", stats.topics[0].topic);
+    EXPECT_EQ(3, stats.topics[0].partitions[0].partition);
+    EXPECT_EQ(5, stats.topics[0].partitions[0].msgqCnt);
+    EXPECT_EQ(100, stats.topics[0].partitions[0].txmsgs);
+    EXPECT_EQ(-1, stats.topics[0].partitions[0].consumerLag);
+    EXPECT_EQ(0, stats.totalConsumerLag());
+
+    // The fields missing in the JSON would not keep the previous values
+    EXPECT_TRUE(stats.clientId.empty());
+    EXPECT_EQ(0, stats.ts);
+    EXPECT_EQ(0, stats.rxmsgs);
+    EXPECT_TRUE(stats.consumerGroup.state.empty());
+    EXPECT_EQ(0, stats.consumerGroup.assignmentSize);
+
+    ASSERT_TRUE(stats.parse(R"({"name": "rdkafka#producer-1"})"));
+    EXPECT_TRUE(stats.brokers.empty());
+    EXPECT_TRUE(stats.topics.empty());
+}
+
+TEST(ClientStatistics, EscapedString)
+{
+    Kafka::ClientStatistics stats;
+    ASSERT_TRUE(stats.parse(R"({"client_id": "my\"client\\1A\u00e9", "unknown": [1, -2.5e3, "x", {"y": [true, null]}], "type": "producer"})"));
+
+    EXPECT_EQ("my\"client\\1A\xC3\xA9", stats.clientId);
+    EXPECT_EQ("producer", stats.type);
+}
+
+TEST(ClientStatistics, MalformedJson)
+{
+    Kafka::ClientStatistics stats;
+
+    EXPECT_FALSE(stats.parse(""));
+    EXPECT_FALSE(stats.parse("[]"));
+    EXPECT_FALSE(stats.parse(R"({"name": "x")"));
+    EXPECT_FALSE(stats.parse(R"({"name": "x)"));
+    EXPECT_FALSE(stats.parse(R"({"brokers": {"b": {"rtt": {"min": -}}}})"));
+    EXPECT_FALSE(stats.parse(STATS_JSON.substr(0, STATS_JSON.size() / 2)));
+
+    EXPECT_TRUE(stats.parse("{}"));
+    EXPECT_TRUE(stats.parse(STATS_JSON));
+}
+
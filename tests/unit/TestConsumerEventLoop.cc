@@ -0,0 +1,136 @@
+#include "kafka/ConsumerEventLoop.h"
+
+#include "gtest/gtest.h"
+
+#ifdef KAFKA_API_ENABLE_COROUTINE
+
+#include <chrono>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace Kafka = KAFKA_API;
+
+namespace {
+
+// A pipe, whose read end would be watched by the loop
+struct Pipe
+{
+    Pipe()  { EXPECT_EQ(0, pipe(fds)); }
+    ~Pipe() { close(fds[0]); close(fds[1]); }
+
+    void notify() const  { EXPECT_EQ(1, write(fds[1], "1", 1)); }
+    bool consume() const { char c = 0; return read(fds[0], &c, 1) == 1; }
+
+    int fds[2] = {-1, -1};
+};
+
+// Resumed once the pipe is readable (returns true), or the loop is stopped (returns false)
+struct ReadableAwaiter
+{
+    Kafka::ConsumerEventLoop& loop;
+    const Pipe&               p;
+    bool                      consumed = false;
+
+    bool await_ready() const { return loop.stopped(); }
+    void await_suspend(std::coroutine_handle<> handle) { loop.wait(p.fds[0], [this]() { return consumed = p.consume(); }, handle); }
+    bool await_resume() const { return consumed; }
+};
+
+Kafka::ConsumerEventLoop::Task waitForNotifications(Kafka::ConsumerEventLoop& loop, const Pipe& p, int& count)
+{
+    for (;;)
+    {
+        ReadableAwaiter awaiter{loop, p};
+        if (!co_await awaiter) break;
+
+        ++count;
+    }
+}
+
+Kafka::ConsumerEventLoop::Task throwOnNotification(Kafka::ConsumerEventLoop& loop, const Pipe& p)
+{
+    ReadableAwaiter awaiter{loop, p};
+    if (co_await awaiter) throw std::runtime_error("notified");
+}
+
+} // end of namespace
+
+
+TEST(ConsumerEventLoop, ResumeReadyCoroutines)
+{
+    Kafka::ConsumerEventLoop loop;
+
+    Pipe p0, p1;
+    int  count0 = 0, count1 = 0;
+
+    auto task0 = waitForNotifications(loop, p0, count0);
+    auto task1 = waitForNotifications(loop, p1, count1);
+    EXPECT_EQ(2, loop.waiting());
+    EXPECT_FALSE(task0.done());
+    EXPECT_FALSE(task1.done());
+
+    // Nothing is ready yet
+    EXPECT_EQ(0, loop.runOnce(std::chrono::milliseconds(10)));
+
+    // Only the coroutine waiting on `p0` would be resumed
+    p0.notify();
+    EXPECT_EQ(1, loop.runOnce(std::chrono::milliseconds(10)));
+    EXPECT_EQ(1, count0);
+    EXPECT_EQ(0, count1);
+
+    // Both are waiting again
+    EXPECT_EQ(2, loop.waiting());
+
+    p0.notify();
+    p1.notify();
+    EXPECT_EQ(2, loop.runOnce(std::chrono::milliseconds(10)));
+    EXPECT_EQ(2, count0);
+    EXPECT_EQ(1, count1);
+
+    // The coroutines would finish once the loop is stopped
+    loop.stop();
+    EXPECT_TRUE(loop.stopped());
+    EXPECT_EQ(0, loop.waiting());
+    EXPECT_TRUE(task0.done());
+    EXPECT_TRUE(task1.done());
+    EXPECT_NO_THROW(task0.get());
+    EXPECT_NO_THROW(task1.get());
+
+    // Run nothing after stopped
+    loop.run();
+    EXPECT_EQ(2, count0);
+    EXPECT_EQ(1, count1);
+}
+
+TEST(ConsumerEventLoop, KeepExceptionWithinTask)
+{
+    Kafka::ConsumerEventLoop loop;
+
+    Pipe p0, p1;
+    int  count = 0;
+
+    auto failing = throwOnNotification(loop, p0);
+    auto normal  = waitForNotifications(loop, p1, count);
+    EXPECT_EQ(2, loop.waiting());
+
+    // The exception would not be thrown to the loop
+    p0.notify();
+    p1.notify();
+    EXPECT_NO_THROW(EXPECT_EQ(2, loop.runOnce(std::chrono::milliseconds(10))));
+    EXPECT_EQ(1, count);
+
+    // But kept by the task
+    EXPECT_TRUE(failing.done());
+    EXPECT_THROW(failing.get(), std::runtime_error);
+
+    // The other coroutine keeps going
+    EXPECT_FALSE(normal.done());
+    EXPECT_EQ(1, loop.waiting());
+
+    loop.stop();
+    EXPECT_TRUE(normal.done());
+    EXPECT_NO_THROW(normal.get());
+}
+
+#endif // KAFKA_API_ENABLE_COROUTINE
+
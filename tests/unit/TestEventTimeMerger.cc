@@ -0,0 +1,176 @@
+#include "kafka/EventTimeMerger.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+namespace Kafka = KAFKA_API;
+
+namespace {
+
+inline Kafka::ConsumerRecord mockConsumerRecord(Kafka::Partition partition, Kafka::Offset offset,
+                                                rd_kafka_resp_err_t respErr = RD_KAFKA_RESP_ERR_NO_ERROR)
+{
+    constexpr std::size_t MSG_PRIVATE_LEN = 128;    // the underlying `rk_kafka_msg_t` is longer than `rk_kafka_message_t`
+    const std::size_t msgSize = sizeof(rd_kafka_message_t) + MSG_PRIVATE_LEN;
+
+    auto* rkMsg = static_cast<rd_kafka_message_t*>(std::malloc(msgSize));
+    std::memset(rkMsg, 0, msgSize);
+
+    rkMsg->partition = partition;
+    rkMsg->offset    = offset;
+    rkMsg->err       = respErr;
+
+    return Kafka::ConsumerRecord(rkMsg);
+}
+
+std::vector<std::pair<Kafka::Partition, Kafka::Offset>> partitionOffsets(const std::vector<Kafka::ConsumerRecord>& records)
+{
+    std::vector<std::pair<Kafka::Partition, Kafka::Offset>> ret;
+    for (const auto& record: records)
+    {
+        ret.emplace_back(record.partition(), record.offset());
+    }
+    return ret;
+}
+
+} // end of namespace
+
+
+TEST(EventTimeMerger, MergeWithEventTime)
+{
+    using PartitionOffsets = std::vector<std::pair<Kafka::Partition, Kafka::Offset>>;
+
+    Kafka::EventTimeMerger merger(100, std::chrono::seconds(10));
+
+    const auto now = Kafka::EventTimeMerger::Clock::now();
+
+    merger.push(mockConsumerRecord(0, 0), 100, now);
+    merger.push(mockConsumerRecord(0, 1), 300, now);
+    merger.push(mockConsumerRecord(0, 2), 500, now);
+
+    // Only one partition seen, -- which means every partition has some record buffered
+    EXPECT_EQ(PartitionOffsets({{0, 0}, {0, 1}, {0, 2}}), partitionOffsets(merger.pop(now)));
+
+    merger.push(mockConsumerRecord(0, 3), 700, now);
+    merger.push(mockConsumerRecord(1, 0), 200, now);
+    merger.push(mockConsumerRecord(1, 1), 600, now);
+    merger.push(mockConsumerRecord(1, 2), 800, now);
+
+    // Stop while partition 0 becomes empty, -- the next record might be earlier than the ones of partition 1
+    EXPECT_EQ(PartitionOffsets({{1, 0}, {1, 1}, {0, 3}}), partitionOffsets(merger.pop(now)));
+    EXPECT_EQ(1, merger.size());
+    EXPECT_EQ(1, merger.size({"", 1}));
+
+    // The lookahead is bounded, -- the record would be emitted once it has been buffered for long enough
+    EXPECT_TRUE(merger.pop(now + std::chrono::seconds(5)).empty());
+    EXPECT_EQ(PartitionOffsets({{1, 2}}), partitionOffsets(merger.pop(now + std::chrono::seconds(10))));
+    EXPECT_EQ(0, merger.size());
+}
+
+TEST(EventTimeMerger, BackpressureWithFullBuffer)
+{
+    using PartitionOffsets = std::vector<std::pair<Kafka::Partition, Kafka::Offset>>;
+
+    Kafka::EventTimeMerger merger(4, std::chrono::seconds(10));
+
+    const auto now = Kafka::EventTimeMerger::Clock::now();
+
+    const Kafka::TopicPartition tp0{"", 0};
+    const Kafka::TopicPartition tp1{"", 1};
+
+    merger.push(mockConsumerRecord(0, 0), 100, now);
+    for (Kafka::Offset o = 0; o < 3; ++o)
+    {
+        merger.push(mockConsumerRecord(1, o), 200 + o, now);
+    }
+    EXPECT_EQ(PartitionOffsets({{0, 0}}), partitionOffsets(merger.pop(now)));
+    EXPECT_TRUE(merger.backpressure().toPause.empty());
+
+    // The buffer is full, -- the partition should be paused, and the records would be emitted without waiting for the others
+    merger.push(mockConsumerRecord(1, 3), 300, now);
+    auto backpressure = merger.backpressure();
+    EXPECT_EQ(Kafka::TopicPartitions({tp1}), backpressure.toPause);
+    EXPECT_TRUE(backpressure.toResume.empty());
+
+    EXPECT_EQ(PartitionOffsets({{1, 0}}), partitionOffsets(merger.pop(now)));
+
+    // Not drained to half yet
+    EXPECT_TRUE(merger.backpressure().toResume.empty());
+
+    merger.push(mockConsumerRecord(0, 1), 250, now);
+    EXPECT_EQ(PartitionOffsets({{1, 1}, {1, 2}, {0, 1}}), partitionOffsets(merger.pop(now)));
+
+    backpressure = merger.backpressure();
+    EXPECT_TRUE(backpressure.toPause.empty());
+    EXPECT_EQ(Kafka::TopicPartitions({tp1}), backpressure.toResume);
+}
+
+TEST(EventTimeMerger, WaitForAssignedPartitions)
+{
+    Kafka::EventTimeMerger merger(100, std::chrono::seconds(10));
+
+    const auto now = Kafka::EventTimeMerger::Clock::now();
+
+    merger.assign({{"", 0}, {"", 1}});
+
+    // Partition 1 has not got any record yet, -- wait for it
+    merger.push(mockConsumerRecord(0, 0), 100, now);
+    EXPECT_TRUE(merger.pop(now).empty());
+
+    // The earlier one would be emitted, -- while the other one would keep waiting for partition 1
+    merger.push(mockConsumerRecord(1, 0), 50, now);
+    const auto records = merger.pop(now);
+    ASSERT_EQ(1, records.size());
+    EXPECT_EQ(1, records[0].partition());
+    EXPECT_EQ(1, merger.size());
+}
+
+TEST(EventTimeMerger, DiscardAndPassthrough)
+{
+    using PartitionOffsets = std::vector<std::pair<Kafka::Partition, Kafka::Offset>>;
+
+    Kafka::EventTimeMerger merger(100, std::chrono::seconds(10));
+
+    const auto now = Kafka::EventTimeMerger::Clock::now();
+
+    merger.push(mockConsumerRecord(0, 0), 100, now);
+    merger.push(mockConsumerRecord(1, 0), 200, now);
+    EXPECT_EQ(PartitionOffsets({{0, 0}}), partitionOffsets(merger.pop(now)));
+
+    // Partition 0 is revoked, -- no need to wait for it any more
+    merger.discard({{"", 0}});
+
+    // The event (e.g, EOF) would be emitted directly
+    merger.push(mockConsumerRecord(2, 5, RD_KAFKA_RESP_ERR__PARTITION_EOF), now);
+
+    EXPECT_EQ(PartitionOffsets({{2, 5}, {1, 0}}), partitionOffsets(merger.pop(now)));
+}
+
+TEST(EventTimeMerger, CommittableOffsets)
+{
+    using PartitionOffsets = std::vector<std::pair<Kafka::Partition, Kafka::Offset>>;
+
+    Kafka::EventTimeMerger merger(100, std::chrono::seconds(10));
+
+    const auto now = Kafka::EventTimeMerger::Clock::now();
+
+    // Nothing emitted or buffered yet
+    merger.assign({{"", 0}, {"", 1}});
+    EXPECT_TRUE(merger.committableOffsets().empty());
+
+    merger.push(mockConsumerRecord(0, 10), 100, now);
+    merger.push(mockConsumerRecord(0, 11), 300, now);
+    merger.push(mockConsumerRecord(1, 20), 200, now);
+    EXPECT_EQ(PartitionOffsets({{0, 10}, {1, 20}}), partitionOffsets(merger.pop(now)));
+
+    // The record buffered (waiting for partition 1) would not be committed
+    EXPECT_EQ(Kafka::TopicPartitionOffsets({{{"", 0}, 11}, {{"", 1}, 21}}), merger.committableOffsets());
+
+    merger.push(mockConsumerRecord(1, 21), 400, now);
+    merger.push(mockConsumerRecord(1, 22), 500, now);
+    EXPECT_EQ(PartitionOffsets({{0, 11}}), partitionOffsets(merger.pop(now)));
+    EXPECT_EQ(Kafka::TopicPartitionOffsets({{{"", 0}, 12}, {{"", 1}, 21}}), merger.committableOffsets());
+}
@@ -0,0 +1,118 @@
+#include "kafka/FlowController.h"
+
+#include "gtest/gtest.h"
+
+namespace Kafka = KAFKA_API;
+
+TEST(FlowController, Disabled)
+{
+    Kafka::FlowController controller(Kafka::FlowController::Watermarks{}, Kafka::FlowController::Watermarks{});
+    EXPECT_FALSE(controller.isEnabled());
+}
+
+TEST(FlowController, PauseAndResumeWithRecords)
+{
+    Kafka::FlowController controller({3, 1}, Kafka::FlowController::Watermarks{});
+    EXPECT_TRUE(controller.isEnabled());
+
+    const Kafka::TopicPartition tp0{"topic", 0};
+    const Kafka::TopicPartition tp1{"topic", 1};
+
+    controller.acquire(tp0, 10);
+    controller.acquire(tp0, 10);
+    controller.acquire(tp1, 10);
+    EXPECT_TRUE(controller.update().toPause.empty());
+
+    // Reached the high watermark
+    controller.acquire(tp0, 10);
+    auto decision = controller.update();
+    EXPECT_EQ(Kafka::TopicPartitions({tp0}), decision.toPause);
+    EXPECT_TRUE(decision.toResume.empty());
+    EXPECT_EQ(Kafka::TopicPartitions({tp0}), controller.paused());
+
+    // Not paused again
+    EXPECT_TRUE(controller.update().toPause.empty());
+
+    // Still above the low watermark
+    controller.release(tp0, 1, 10);
+    EXPECT_TRUE(controller.update().toResume.empty());
+
+    // Fell to the low watermark
+    controller.release(tp0, 1, 10);
+    decision = controller.update();
+    EXPECT_TRUE(decision.toPause.empty());
+    EXPECT_EQ(Kafka::TopicPartitions({tp0}), decision.toResume);
+    EXPECT_TRUE(controller.paused().empty());
+
+    EXPECT_EQ(1, controller.inFlight(tp0).records);
+    EXPECT_EQ(10, controller.inFlight(tp0).bytes);
+}
+
+TEST(FlowController, PauseWithBytes)
+{
+    Kafka::FlowController controller(Kafka::FlowController::Watermarks{}, {100, 50});
+
+    const Kafka::TopicPartition tp{"topic", 0};
+
+    controller.acquire(tp, 60);
+    EXPECT_TRUE(controller.update().toPause.empty());
+
+    controller.acquire(tp, 60);
+    EXPECT_EQ(Kafka::TopicPartitions({tp}), controller.update().toPause);
+
+    controller.release(tp, 1, 60);
+    EXPECT_TRUE(controller.update().toResume.empty());
+
+    controller.release(tp, 1, 60);
+    EXPECT_EQ(Kafka::TopicPartitions({tp}), controller.update().toResume);
+}
+
+TEST(FlowController, Discard)
+{
+    Kafka::FlowController controller({1, 0}, Kafka::FlowController::Watermarks{});
+
+    const Kafka::TopicPartition tp{"topic", 0};
+
+    controller.acquire(tp, 10);
+    EXPECT_EQ(Kafka::TopicPartitions({tp}), controller.update().toPause);
+
+    // Revoked, -- the later releases would be ignored
+    controller.discard({tp});
+    controller.release(tp, 1, 10);
+
+    EXPECT_TRUE(controller.paused().empty());
+    EXPECT_EQ(0, controller.inFlight(tp).records);
+    EXPECT_TRUE(controller.update().toResume.empty());
+}
+
+TEST(FlowController, ReleaseAfterReassigned)
+{
+    Kafka::FlowController controller({2, 0}, Kafka::FlowController::Watermarks{});
+
+    const Kafka::TopicPartition tp{"topic", 0};
+
+    controller.acquire(tp, 10);
+    controller.acquire(tp, 10);
+    EXPECT_EQ(Kafka::TopicPartitions({tp}), controller.update().toPause);
+
+    // Revoked, -- the records polled before are dropped (never released)
+    controller.discard({tp});
+    EXPECT_TRUE(controller.paused().empty());
+
+    // Re-assigned, with new records polled
+    controller.acquire(tp, 20);
+    controller.acquire(tp, 20);
+    EXPECT_EQ(Kafka::TopicPartitions({tp}), controller.update().toPause);
+
+    // The releases for the new records would drain it
+    controller.release(tp, 2, 40);
+    EXPECT_EQ(0, controller.inFlight(tp).records);
+    EXPECT_EQ(0, controller.inFlight(tp).bytes);
+    EXPECT_EQ(Kafka::TopicPartitions({tp}), controller.update().toResume);
+
+    // A late release (for the records polled before the revoke) never leaves it stuck
+    controller.acquire(tp, 20);
+    controller.release(tp, 2, 20);
+    EXPECT_EQ(0, controller.inFlight(tp).records);
+    EXPECT_TRUE(controller.update().toPause.empty());
+}
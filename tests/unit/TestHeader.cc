@@ -35,3 +35,20 @@ TEST(Header, Headers)
     EXPECT_EQ("k1:v1,k2:v2,k3:v3", Kafka::toString(headers));
 }
 
+TEST(Header, HeaderView)
+{
+    const char*       key   = "k1";
+    const std::string value = "v1";
+
+    Kafka::HeaderView view(key, Kafka::Header::Value(value.c_str(), value.size()));
+    EXPECT_TRUE(view.keyEquals("k1"));
+    EXPECT_FALSE(view.keyEquals("k2"));
+    EXPECT_FALSE(view.keyEquals("k"));
+
+    // Copy to an owning header
+    Kafka::Header header = view.toHeader();
+    EXPECT_EQ("k1", header.key);
+    EXPECT_EQ(value.c_str(), header.value.data());
+    EXPECT_EQ("k1:v1", view.toString());
+}
+
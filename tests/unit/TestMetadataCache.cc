@@ -0,0 +1,78 @@
+#include "kafka/MetadataCache.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace Kafka = KAFKA_API;
+
+TEST(MetadataCache, ExpireWithTTL)
+{
+    using namespace std::chrono;
+
+    Kafka::MetadataCache cache(milliseconds(1000));
+
+    const auto start = Kafka::MetadataCache::Clock::now();
+
+    EXPECT_FALSE(cache.get("topic", start));
+
+    cache.put("topic", Kafka::BrokerMetadata("topic"), start);
+    EXPECT_EQ(1, cache.size());
+
+    auto metadata = cache.get("topic", start + milliseconds(999));
+    ASSERT_TRUE(metadata);
+    EXPECT_EQ("topic", metadata->topic());
+
+    // Expired
+    EXPECT_FALSE(cache.get("topic", start + milliseconds(1000)));
+
+    // Updated
+    cache.put("topic", Kafka::BrokerMetadata("topic"), start + milliseconds(1000));
+    EXPECT_TRUE(cache.get("topic", start + milliseconds(1999)));
+}
+
+TEST(MetadataCache, Invalidate)
+{
+    Kafka::MetadataCache cache(std::chrono::seconds(10));
+
+    cache.put("topic1", Kafka::BrokerMetadata("topic1"));
+    cache.put("topic2", Kafka::BrokerMetadata("topic2"));
+
+    auto metadata = cache.get("topic1");
+    ASSERT_TRUE(metadata);
+
+    cache.invalidate("topic1");
+    EXPECT_FALSE(cache.get("topic1"));
+    EXPECT_TRUE(cache.get("topic2"));
+
+    // The metadata got before would still be valid
+    EXPECT_EQ("topic1", metadata->topic());
+}
+
+TEST(MetadataCache, RefreshBeforeExpiry)
+{
+    using namespace std::chrono;
+
+    std::atomic<int> fetched(0);
+    Kafka::MetadataCache cache(milliseconds(1000),
+                               [&fetched](const Kafka::Topic& topic, milliseconds /*timeout*/) {
+                                   ++fetched;
+                                   return Optional<Kafka::BrokerMetadata>(Kafka::BrokerMetadata(topic));
+                               });
+
+    const auto start = Kafka::MetadataCache::Clock::now() - milliseconds(900);
+    cache.put("topic", Kafka::BrokerMetadata("topic"), start);
+
+    // Not expired yet, -- but old enough to be refreshed (for only once)
+    EXPECT_TRUE(cache.get("topic"));
+    EXPECT_TRUE(cache.get("topic"));
+
+    for (int i = 0; i < 100 && fetched == 0; ++i) std::this_thread::sleep_for(milliseconds(10));
+    EXPECT_EQ(1, fetched);
+
+    // The refreshed entry would still be valid after the old one expired
+    EXPECT_TRUE(cache.get("topic", start + milliseconds(1500)));
+}
+
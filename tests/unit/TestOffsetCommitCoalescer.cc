@@ -0,0 +1,255 @@
+#include "kafka/OffsetCommitCoalescer.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace Kafka = KAFKA_API;
+
+TEST(OffsetCommitCoalescer, Disabled)
+{
+    Kafka::OffsetCommitCoalescer coalescer;
+    EXPECT_FALSE(coalescer.isEnabled());
+    EXPECT_FALSE(coalescer.isDue());
+
+    const Kafka::TopicPartition tp{"topic", 0};
+
+    // Without coalescing, every request should be flushed immediately
+    for (Kafka::Offset o = 1; o <= 3; ++o)
+    {
+        coalescer.merge({{tp, o}});
+        EXPECT_TRUE(coalescer.isDue());
+
+        auto flushed = coalescer.flush();
+        EXPECT_EQ(Kafka::TopicPartitionOffsets({{tp, o}}), flushed);
+        EXPECT_TRUE(coalescer.empty());
+    }
+
+    EXPECT_EQ(3, coalescer.statistics().requested);
+    EXPECT_EQ(3, coalescer.statistics().sent);
+    EXPECT_EQ(0, coalescer.statistics().saved());
+}
+
+TEST(OffsetCommitCoalescer, CoalescedByInterval)
+{
+    using namespace std::chrono;
+
+    Kafka::OffsetCommitCoalescer coalescer(milliseconds(1000));
+    EXPECT_TRUE(coalescer.isEnabled());
+
+    const auto start = Kafka::OffsetCommitCoalescer::Clock::now();
+
+    const Kafka::TopicPartition tp0{"topic", 0};
+    const Kafka::TopicPartition tp1{"topic", 1};
+
+    coalescer.merge({{tp0, 10}, {tp1, 5}});
+    coalescer.merge({{tp0, 20}});
+    // The smaller offset would not override the larger one
+    coalescer.merge({{tp1, 3}});
+
+    EXPECT_FALSE(coalescer.isDue(start));
+    EXPECT_TRUE(coalescer.isDue(start + milliseconds(1000)));
+
+    auto flushed = coalescer.flush(start + milliseconds(1000));
+    EXPECT_EQ(Kafka::TopicPartitionOffsets({{tp0, 20}, {tp1, 5}}), flushed);
+    EXPECT_FALSE(coalescer.isDue(start + milliseconds(3000)));
+
+    // Offsets which had been flushed would not be committed again
+    coalescer.merge({{tp0, 20}});
+    EXPECT_TRUE(coalescer.empty());
+
+    EXPECT_EQ(4, coalescer.statistics().requested);
+    EXPECT_EQ(1, coalescer.statistics().sent);
+    EXPECT_EQ(3, coalescer.statistics().saved());
+}
+
+TEST(OffsetCommitCoalescer, CoalescedByOffsetDelta)
+{
+    using namespace std::chrono;
+
+    Kafka::OffsetCommitCoalescer coalescer(hours(1), 100);
+
+    const auto start = Kafka::OffsetCommitCoalescer::Clock::now();
+
+    const Kafka::TopicPartition tp{"topic", 0};
+
+    coalescer.merge({{tp, 1000}});
+    coalescer.flush(start);
+
+    coalescer.merge({{tp, 1050}});
+    EXPECT_FALSE(coalescer.isDue(start));
+
+    // Accumulated delta reached the threshold
+    coalescer.merge({{tp, 1100}});
+    EXPECT_TRUE(coalescer.isDue(start));
+
+    EXPECT_EQ(Kafka::TopicPartitionOffsets({{tp, 1100}}), coalescer.flush(start));
+}
+
+TEST(OffsetCommitCoalescer, Discard)
+{
+    Kafka::OffsetCommitCoalescer coalescer(std::chrono::hours(1));
+
+    const Kafka::TopicPartition tp0{"topic", 0};
+    const Kafka::TopicPartition tp1{"topic", 1};
+
+    coalescer.merge({{tp0, 10}, {tp1, 10}});
+    coalescer.discard({tp0});
+
+    EXPECT_EQ(Kafka::TopicPartitionOffsets({{tp1, 10}}), coalescer.pending());
+}
+
+TEST(OffsetCommitCoalescer, FlushPartially)
+{
+    Kafka::OffsetCommitCoalescer coalescer(std::chrono::hours(1));
+
+    const Kafka::TopicPartition tp0{"topic", 0};
+    const Kafka::TopicPartition tp1{"topic", 1};
+
+    coalescer.merge({{tp0, 10}, {tp1, 10}});
+
+    // Only the offsets for the given partitions would be taken away
+    EXPECT_EQ(Kafka::TopicPartitionOffsets({{tp0, 10}}), coalescer.flush({tp0}));
+    EXPECT_EQ(Kafka::TopicPartitionOffsets({{tp1, 10}}), coalescer.pending());
+
+    // Nothing pending for these partitions
+    EXPECT_TRUE(coalescer.flush({tp0}).empty());
+    EXPECT_EQ(1, coalescer.statistics().sent);
+}
+
+TEST(OffsetCommitCoalescer, OffsetDeltaAfterPartialFlush)
+{
+    using namespace std::chrono;
+
+    Kafka::OffsetCommitCoalescer coalescer(hours(1), 100);
+
+    const auto start = Kafka::OffsetCommitCoalescer::Clock::now();
+
+    const Kafka::TopicPartition tp0{"topic", 0};
+    const Kafka::TopicPartition tp1{"topic", 1};
+    const Kafka::TopicPartition tp2{"topic", 2};
+
+    coalescer.merge({{tp0, 1000}, {tp1, 1000}, {tp2, 1000}});
+    coalescer.flush(start);
+
+    coalescer.merge({{tp0, 1080}, {tp1, 1010}, {tp2, 1005}});
+    EXPECT_FALSE(coalescer.isDue(start));
+
+    // The delta contributed by tp0 is taken away with it
+    coalescer.flush({tp0});
+    coalescer.merge({{tp1, 1090}});
+    EXPECT_FALSE(coalescer.isDue(start));
+
+    // The delta contributed by tp2 is dropped with it
+    coalescer.discard({tp2});
+    coalescer.merge({{tp1, 1099}});
+    EXPECT_FALSE(coalescer.isDue(start));
+
+    // Now reached the threshold (with tp1 only)
+    coalescer.merge({{tp1, 1100}});
+    EXPECT_TRUE(coalescer.isDue(start));
+}
+
+TEST(OffsetCommitCoalescer, CallbacksWithPartialFlush)
+{
+    Kafka::OffsetCommitCoalescer coalescer(std::chrono::hours(1));
+
+    const Kafka::TopicPartition retained{"topic", 0};
+    const Kafka::TopicPartition revoked{"topic", 1};
+
+    std::vector<std::string> triggered;
+
+    coalescer.merge({{retained, 10}});
+    coalescer.addCallback({{retained, 10}}, [&triggered](const Kafka::TopicPartitionOffsets&, std::error_code) { triggered.emplace_back("retained"); });
+    coalescer.merge({{revoked, 20}});
+    coalescer.addCallback({{revoked, 20}}, [&triggered](const Kafka::TopicPartitionOffsets&, std::error_code) { triggered.emplace_back("revoked"); });
+
+    // Only the callback for the revoked partition is served by the partial flush
+    auto revokedOffsets = coalescer.flush({revoked});
+    coalescer.takeCallbacks(revokedOffsets)(revokedOffsets, std::error_code());
+    coalescer.discard({revoked});
+    EXPECT_EQ(std::vector<std::string>({"revoked"}), triggered);
+
+    // The other one would be triggered with the commit for the retained partition
+    auto retainedOffsets = coalescer.flush();
+    EXPECT_EQ(Kafka::TopicPartitionOffsets({{retained, 10}}), retainedOffsets);
+    coalescer.takeCallbacks(retainedOffsets)(retainedOffsets, std::error_code());
+    EXPECT_EQ(std::vector<std::string>({"revoked", "retained"}), triggered);
+}
+
+TEST(OffsetCommitCoalescer, CallbackAcrossPartialFlush)
+{
+    Kafka::OffsetCommitCoalescer coalescer(std::chrono::hours(1));
+
+    const Kafka::TopicPartition tp0{"topic", 0};
+    const Kafka::TopicPartition tp1{"topic", 1};
+
+    int             triggered = 0;
+    std::error_code result;
+
+    coalescer.merge({{tp0, 10}, {tp1, 20}});
+    coalescer.addCallback({{tp0, 10}, {tp1, 20}}, [&](const Kafka::TopicPartitionOffsets&, std::error_code ec) { ++triggered; result = ec; });
+
+    // The first commit (for tp1) failed, -- the callback waits for tp0, and would report the error then
+    auto tp1Offsets = coalescer.flush({tp1});
+    coalescer.takeCallbacks(tp1Offsets)(tp1Offsets, Kafka::ErrorCode(RD_KAFKA_RESP_ERR_REQUEST_TIMED_OUT));
+    EXPECT_EQ(0, triggered);
+
+    auto tp0Offsets = coalescer.flush();
+    coalescer.takeCallbacks(tp0Offsets)(tp0Offsets, std::error_code());
+    EXPECT_EQ(1, triggered);
+    EXPECT_EQ(RD_KAFKA_RESP_ERR_REQUEST_TIMED_OUT, result.value());
+
+    // The partition is lost before the pending offsets are committed
+    coalescer.merge({{tp0, 30}});
+    coalescer.addCallback({{tp0, 30}}, [&](const Kafka::TopicPartitionOffsets&, std::error_code ec) { ++triggered; result = ec; });
+    coalescer.discard({tp0});
+    EXPECT_EQ(2, triggered);
+    EXPECT_EQ(RD_KAFKA_RESP_ERR__ASSIGNMENT_LOST, result.value());
+}
+
+TEST(OffsetCommitCoalescer, RewindWithoutCoalescing)
+{
+    Kafka::OffsetCommitCoalescer coalescer;
+
+    const Kafka::TopicPartition tp{"topic", 0};
+
+    coalescer.merge({{tp, 100}});
+    coalescer.flush();
+
+    // E.g, after a seek backwards, the smaller offset would still be committed
+    coalescer.merge({{tp, 10}});
+    EXPECT_EQ(Kafka::TopicPartitionOffsets({{tp, 10}}), coalescer.flush());
+}
+
+TEST(OffsetCommitCoalescer, CoversAndMarkFlushed)
+{
+    Kafka::OffsetCommitCoalescer coalescer(std::chrono::hours(1));
+
+    const Kafka::TopicPartition tp0{"topic", 0};
+    const Kafka::TopicPartition tp1{"topic", 1};
+
+    coalescer.merge({{tp0, 10}, {tp1, 10}});
+    EXPECT_TRUE(coalescer.covers({{tp0, 10}, {tp1, 5}}));
+    coalescer.flush();
+
+    // Not larger than the flushed offsets, -- would not be covered by the pending ones
+    coalescer.merge({{tp0, 20}, {tp1, 5}});
+    EXPECT_TRUE(coalescer.covers({{tp0, 20}}));
+    EXPECT_FALSE(coalescer.covers({{tp0, 20}, {tp1, 5}}));
+
+    // Committed directly (after the pending ones), -- the larger offsets would be coalesced again
+    coalescer.flush();
+    coalescer.markFlushed({{tp1, 5}});
+    coalescer.merge({{tp1, 8}});
+    EXPECT_EQ(Kafka::TopicPartitionOffsets({{tp1, 8}}), coalescer.pending());
+    EXPECT_EQ(3, coalescer.statistics().sent);
+
+    // After a seek, the flushed offsets are forgotten
+    coalescer.discard({tp0});
+    coalescer.merge({{tp0, 1}});
+    EXPECT_TRUE(coalescer.covers({{tp0, 1}}));
+}
@@ -0,0 +1,53 @@
+#include "kafka/KafkaConsumer.h"
+
+#include "gtest/gtest.h"
+
+namespace Kafka = KAFKA_API;
+
+namespace {
+
+Kafka::Consumer::PartitionLag partitionLag(Kafka::Offset position, Kafka::Offset highWatermark)
+{
+    Kafka::Consumer::PartitionLag lag;
+    lag.position      = position;
+    lag.highWatermark = highWatermark;
+    return lag;
+}
+
+} // end of namespace
+
+TEST(PrioritizationPolicy, PauseHeadPartitions)
+{
+    const Kafka::TopicPartition tp0{"topic", 0};
+    const Kafka::TopicPartition tp1{"topic", 1};
+    const Kafka::TopicPartition tp2{"topic", 2};
+    const Kafka::TopicPartition tp3{"topic", 3};
+
+    const auto policy = Kafka::Consumer::prioritizeLaggingPartitions(1000, 0.1);
+
+    Kafka::Consumer::LagTable lags;
+    lags[tp0] = partitionLag(100, 100000);  // lagging far behind
+    lags[tp1] = partitionLag(100, 150);     // near the head
+    lags[tp2] = partitionLag(100, 100);     // at the head
+    lags[tp3] = partitionLag(Kafka::Consumer::PartitionLag().position, 100); // unknown
+
+    // The ones near the head would be paused, -- and never the one with unknown lag
+    EXPECT_EQ(Kafka::TopicPartitions({tp1, tp2}), policy(lags));
+
+    // The lags evened out
+    lags[tp0] = partitionLag(99500, 100000);
+    EXPECT_TRUE(policy(lags).empty());
+}
+
+TEST(PrioritizationPolicy, NothingToPrioritize)
+{
+    const auto policy = Kafka::Consumer::prioritizeLaggingPartitions(1000);
+
+    EXPECT_TRUE(policy(Kafka::Consumer::LagTable()).empty());
+
+    // All caught up
+    Kafka::Consumer::LagTable lags;
+    lags[{"topic", 0}] = partitionLag(100, 100);
+    lags[{"topic", 1}] = partitionLag(200, 200);
+    EXPECT_TRUE(policy(lags).empty());
+}